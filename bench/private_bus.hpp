@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <systemd/sd-bus.h>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace obmc
+{
+namespace session
+{
+namespace bench
+{
+
+/**
+ * @brief The private bus daemon started for the benchmark tools and the tests.
+ */
+class PrivateBus
+{
+  public:
+    PrivateBus(const PrivateBus&) = delete;
+    PrivateBus& operator=(const PrivateBus&) = delete;
+    PrivateBus(PrivateBus&&) = delete;
+    PrivateBus& operator=(PrivateBus&&) = delete;
+
+    PrivateBus() : pid(-1)
+    {
+        FILE* output = ::popen("dbus-daemon --session --fork "
+                               "--print-address=1 --print-pid=1",
+                               "r");
+        if (output == nullptr)
+        {
+            throw std::runtime_error("Failure to start dbus-daemon");
+        }
+        std::array<char, 512> line{};
+        if (std::fgets(line.data(), line.size(), output) != nullptr)
+        {
+            address = line.data();
+            address.erase(address.find_last_not_of('\n') + 1);
+        }
+        if (std::fgets(line.data(), line.size(), output) != nullptr)
+        {
+            pid = static_cast<pid_t>(std::atoi(line.data()));
+        }
+        ::pclose(output);
+        if (address.empty() || pid <= 0)
+        {
+            throw std::runtime_error("Failure to get the dbus-daemon address");
+        }
+    }
+
+    ~PrivateBus()
+    {
+        if (pid > 0)
+        {
+            ::kill(pid, SIGTERM);
+        }
+    }
+
+    const std::string& getAddress() const
+    {
+        return address;
+    }
+
+  private:
+    std::string address;
+    pid_t pid;
+};
+
+/**
+ * @brief Connect a new client to the bus at the specified address.
+ *
+ * @param[in] address - the address of the bus.
+ *
+ * @return sd_bus* - the started connection owned by the caller.
+ */
+inline sd_bus* connectBus(const std::string& address)
+{
+    sd_bus* bus = nullptr;
+    int rc = sd_bus_new(&bus);
+    if (rc >= 0)
+    {
+        rc = sd_bus_set_address(bus, address.c_str());
+    }
+    if (rc >= 0)
+    {
+        rc = sd_bus_set_bus_client(bus, 1);
+    }
+    if (rc >= 0)
+    {
+        rc = sd_bus_start(bus);
+    }
+    if (rc < 0)
+    {
+        sd_bus_unref(bus);
+        throw std::runtime_error(std::string("Failure to connect the bus: ") +
+                                 std::strerror(-rc));
+    }
+    return bus;
+}
+
+/**
+ * @brief The real service started on the private bus with the journal, the
+ *        audit ring and the session table in temporary files.
+ */
+class ServiceProcess
+{
+  public:
+    static constexpr const char* serviceName =
+        "xyz.openbmc_project.SessionManager";
+    static constexpr auto startTimeout = std::chrono::seconds(10);
+
+    ServiceProcess() = delete;
+    ServiceProcess(const ServiceProcess&) = delete;
+    ServiceProcess& operator=(const ServiceProcess&) = delete;
+    ServiceProcess(ServiceProcess&&) = delete;
+    ServiceProcess& operator=(ServiceProcess&&) = delete;
+
+    /** @brief Starts the service, it connects the private bus as the system
+     *         one.
+     *
+     * @param[in] servicePath   - the path of the service executable
+     * @param[in] address       - the address of the private bus
+     */
+    ServiceProcess(const std::string& servicePath,
+                   const std::string& address) :
+        address(address),
+        pathPrefix("/tmp/session-manager." + std::to_string(::getpid())),
+        pid(-1)
+    {
+        pid = ::fork();
+        if (pid < 0)
+        {
+            throw std::runtime_error("Failure to fork the service");
+        }
+        if (pid == 0)
+        {
+            ::setenv("DBUS_SYSTEM_BUS_ADDRESS", address.c_str(), 1);
+            ::setenv("DBUS_STARTER_BUS_TYPE", "system", 1);
+            const auto journalPath = pathPrefix + ".journal";
+            const auto auditPath = pathPrefix + ".audit";
+            const auto tablePath = pathPrefix + ".table";
+            ::execl(servicePath.c_str(), servicePath.c_str(), "-j",
+                    journalPath.c_str(), "-a", auditPath.c_str(), "-t",
+                    tablePath.c_str(), nullptr);
+            ::_exit(127);
+        }
+    }
+
+    /** @brief Stops the service and removes its files. */
+    ~ServiceProcess()
+    {
+        if (pid > 0)
+        {
+            ::kill(pid, SIGTERM);
+            ::waitpid(pid, nullptr, 0);
+        }
+        ::unlink((pathPrefix + ".journal").c_str());
+        ::unlink((pathPrefix + ".audit").c_str());
+        ::unlink((pathPrefix + ".table").c_str());
+    }
+
+    /**
+     * @brief Wait until the service acquires its name.
+     *
+     * @param[in] idle  - the callback to invoke between the polls, e.g. to
+     *                    serve the calls the service makes on startup
+     */
+    void waitReady(const std::function<void()>& idle = nullptr) const
+    {
+        sd_bus* bus = connectBus(address);
+        const auto deadline = std::chrono::steady_clock::now() + startTimeout;
+        int hasOwner = 0;
+        while (!hasOwner && std::chrono::steady_clock::now() < deadline)
+        {
+            sd_bus_error error = SD_BUS_ERROR_NULL;
+            sd_bus_message* reply = nullptr;
+            if (sd_bus_call_method(bus, "org.freedesktop.DBus",
+                                   "/org/freedesktop/DBus",
+                                   "org.freedesktop.DBus", "NameHasOwner",
+                                   &error, &reply, "s", serviceName) >= 0)
+            {
+                sd_bus_message_read(reply, "b", &hasOwner);
+            }
+            sd_bus_message_unref(reply);
+            sd_bus_error_free(&error);
+            if (!hasOwner)
+            {
+                if (idle)
+                {
+                    idle();
+                }
+                ::usleep(10000U);
+            }
+        }
+        sd_bus_flush_close_unref(bus);
+        if (!hasOwner)
+        {
+            throw std::runtime_error("The service has not acquired its name");
+        }
+    }
+
+    pid_t getPid() const
+    {
+        return pid;
+    }
+
+  private:
+    std::string address;
+    std::string pathPrefix;
+    pid_t pid;
+};
+
+} // namespace bench
+} // namespace session
+} // namespace obmc
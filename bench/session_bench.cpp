@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include <alloc_accounting.hpp>
+#include <boost/asio.hpp>
+#include <manager.hpp>
+#include <private_bus.hpp>
+#include <sdbusplus/asio/connection.hpp>
+#include <sdbusplus/asio/object_server.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace obmc::session;
+using namespace obmc::session::bench;
+using Clock = std::chrono::steady_clock;
+using Latencies = std::vector<Clock::duration>;
+
+namespace
+{
+
+constexpr std::size_t sessionCounts[] = {1000U, 10000U, 100000U};
+// Let sd-bus write out the queued signals every so many operations, so the
+// outgoing queue of the connection never overflows.
+constexpr std::size_t flushInterval = 1000U;
+
+std::chrono::duration<double, std::micro> percentile(Latencies& latencies,
+                                                     unsigned int rank)
+{
+    if (latencies.empty())
+    {
+        return {};
+    }
+    const auto pos = (latencies.size() - 1U) * rank / 100U;
+    std::nth_element(latencies.begin(), latencies.begin() + pos,
+                     latencies.end());
+    return latencies[pos];
+}
+
+void report(const char* operation, std::size_t sessions,
+            Latencies& latencies, Clock::duration total)
+{
+    const auto seconds = std::chrono::duration<double>(total).count();
+    const auto throughput =
+        seconds > 0.0 ? static_cast<double>(latencies.size()) / seconds : 0.0;
+    std::printf("%-16s %8zu %8zu %14.0f %10.1f %10.1f\n", operation, sessions,
+                latencies.size(), throughput,
+                percentile(latencies, 50U).count(),
+                percentile(latencies, 99U).count());
+}
+
+std::size_t heapInUse()
+{
+    const struct mallinfo2 info = ::mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+template <typename Operation>
+Clock::duration measure(Latencies& latencies, Operation&& operation)
+{
+    const auto start = Clock::now();
+    operation();
+    const auto elapsed = Clock::now() - start;
+    latencies.push_back(elapsed);
+    return elapsed;
+}
+
+void run(SessionManager& manager, sdbusplus::bus::bus& bus,
+         boost::asio::io_context& io, std::size_t sessions)
+{
+    const auto type = SessionManager::SessionType::Redfish;
+    const auto ownerPid = static_cast<int32_t>(::getpid());
+
+    std::vector<std::string> ids;
+    ids.reserve(sessions);
+
+    Latencies latencies;
+    latencies.reserve(sessions);
+    Clock::duration total{};
+    const auto heapBefore = heapInUse();
+    for (std::size_t i = 0U; i < sessions; ++i)
+    {
+        total += measure(latencies, [&]() {
+            ids.emplace_back(manager.create("bench" + std::to_string(i % 64U),
+                                            "10.0.0." +
+                                                std::to_string(i % 250U),
+                                            type, ownerPid));
+        });
+        if (i % flushInterval == 0U)
+        {
+            bus.flush();
+        }
+    }
+    report("create", sessions, latencies, total);
+    bus.flush();
+    // The heap growth includes the session ID strings kept by the benchmark.
+    const auto heapAfter = heapInUse();
+    std::printf("heap per session: %zu bytes\n",
+                heapAfter > heapBefore ? (heapAfter - heapBefore) / sessions
+                                       : 0U);
+
+    latencies.clear();
+    total = measure(latencies, [&]() { manager.reapDeadOwners(); });
+    report("owner-scan", sessions, latencies, total);
+
+    latencies.clear();
+    total = {};
+    for (std::size_t i = 0U; i < ids.size(); i += 2U)
+    {
+        total += measure(latencies, [&]() { manager.close(ids[i]); });
+        if (i % flushInterval == 0U)
+        {
+            bus.flush();
+        }
+    }
+    report("close", sessions, latencies, total);
+    bus.flush();
+
+    latencies.clear();
+    total = measure(latencies, [&]() { manager.closeAllByType(type); });
+    report("closeAllByType", sessions, latencies, total);
+
+    // The session objects of the bulk close are destroyed by the loop.
+    latencies.clear();
+    total = measure(latencies, [&]() { io.poll(); });
+    report("teardown", sessions, latencies, total);
+    bus.flush();
+}
+
+} // namespace
+
+int main()
+{
+    try
+    {
+        PrivateBus privateBus;
+        boost::asio::io_context io;
+        auto conn = std::make_shared<sdbusplus::asio::connection>(
+            io, connectBus(privateBus.getAddress()));
+        sdbusplus::asio::object_server server(conn, true);
+        // Keep the journal, the audit and the session table of the running
+        // service intact.
+        const auto pathPrefix =
+            "/tmp/session-manager-bench." + std::to_string(::getpid());
+        const auto journalPath = pathPrefix + ".journal";
+        const auto auditPath = pathPrefix + ".audit";
+        const auto tablePath = pathPrefix + ".table";
+        auto manager = std::make_shared<SessionManager>(
+            *conn, io, server, journalPath, auditPath, tablePath);
+
+        std::printf("%-16s %8s %8s %14s %10s %10s\n", "operation", "sessions",
+                    "ops", "ops/s", "p50(us)", "p99(us)");
+        for (const auto sessions : sessionCounts)
+        {
+            run(*manager, *conn, io, sessions);
+        }
+
+        const auto& createAllocs = manager->getCreateAllocations();
+        const auto& closeAllocs = manager->getCloseAllocations();
+        if (obmc::alloc::allocations() != 0U && createAllocs.operations != 0U &&
+            closeAllocs.operations != 0U)
+        {
+            std::printf("allocations per create: %.1f, per close: %.1f\n",
+                        static_cast<double>(createAllocs.allocations) /
+                            static_cast<double>(createAllocs.operations),
+                        static_cast<double>(closeAllocs.allocations) /
+                            static_cast<double>(closeAllocs.operations));
+        }
+        ::unlink(journalPath.c_str());
+        ::unlink(auditPath.c_str());
+        ::unlink(tablePath.c_str());
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "Benchmark failed: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,762 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/asio.hpp>
+#include <dbus.hpp>
+#include <private_bus.hpp>
+#include <sdbusplus/asio/connection.hpp>
+#include <sdbusplus/bus/match.hpp>
+#include <systemd/sd-bus.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+using namespace obmc::session::bench;
+using Clock = std::chrono::steady_clock;
+using Latencies = std::vector<Clock::duration>;
+
+namespace
+{
+
+constexpr const char* serviceName = ServiceProcess::serviceName;
+constexpr const char* managerPath = "/xyz/openbmc_project/session_manager";
+constexpr const char* statsPath = "/xyz/openbmc_project/session_manager/stats";
+constexpr const char* managerInterface = "xyz.openbmc_project.Session.Manager";
+constexpr const char* sessionTypes[] = {
+    "xyz.openbmc_project.Session.Item.Type.Redfish",
+    "xyz.openbmc_project.Session.Item.Type.HostConsole",
+    "xyz.openbmc_project.Session.Item.Type.ManagerConsole",
+};
+constexpr unsigned int userCount = 32U;
+constexpr auto pingInterval = std::chrono::milliseconds(100);
+// The time to wait for the service to reap the sessions of the last owners.
+constexpr auto settleTimeout = std::chrono::seconds(30);
+
+struct Options
+{
+    std::string servicePath;
+    std::chrono::seconds duration{60};
+    std::chrono::seconds reportInterval{10};
+    unsigned int concurrency = 64U;
+    unsigned int crashPercent = 20U;
+    unsigned int maxSessionsPerOwner = 3U;
+    unsigned int maxHoldMs = 50U;
+};
+
+/**
+ * @brief The record an owner process writes to the report pipe for each
+ *        operation. It fits PIPE_BUF, so concurrent writes never interleave.
+ */
+struct OwnerReport
+{
+    enum class Kind : uint8_t
+    {
+        created,
+        closed,
+        failed,
+    };
+
+    pid_t owner;
+    Kind kind;
+    uint32_t latencyUs;
+    std::array<char, 24> sessionId;
+};
+static_assert(sizeof(OwnerReport) <= PIPE_BUF);
+
+void sendReport(int reportFd, OwnerReport::Kind kind, Clock::duration latency,
+                const char* sessionId)
+{
+    OwnerReport report{};
+    report.owner = ::getpid();
+    report.kind = kind;
+    report.latencyUs = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(latency)
+            .count());
+    if (sessionId != nullptr)
+    {
+        std::strncpy(report.sessionId.data(), sessionId,
+                     report.sessionId.size() - 1U);
+    }
+    // The write of the record is atomic for the pipe.
+    [[maybe_unused]] const auto written =
+        ::write(reportFd, &report, sizeof(report));
+}
+
+/**
+ * @brief The body of a fake session owner: create a few sessions, list them,
+ *        hold them a while and either close them or die without closing.
+ */
+[[noreturn]] void runOwner(const std::string& address, int reportFd,
+                           const Options& options, unsigned int seed)
+{
+    std::minstd_rand random(seed);
+    const auto ownerPid = static_cast<int32_t>(::getpid());
+    const bool crash = random() % 100U < options.crashPercent;
+    const auto count = 1U + random() % options.maxSessionsPerOwner;
+
+    sd_bus* bus = nullptr;
+    try
+    {
+        bus = connectBus(address);
+    }
+    catch (const std::exception&)
+    {
+        ::_exit(EXIT_FAILURE);
+    }
+
+    std::vector<std::string> ids;
+    const auto user = "loadgen" + std::to_string(random() % userCount);
+    for (unsigned int i = 0U; i < count; ++i)
+    {
+        const auto remoteAddress = "10.0." + std::to_string(random() % 250U) +
+                                   "." + std::to_string(random() % 250U);
+        const char* type =
+            sessionTypes[random() % (sizeof(sessionTypes) /
+                                     sizeof(sessionTypes[0]))];
+        sd_bus_error error = SD_BUS_ERROR_NULL;
+        sd_bus_message* reply = nullptr;
+        const auto start = Clock::now();
+        int rc = sd_bus_call_method(bus, serviceName, managerPath,
+                                    managerInterface, "Create", &error,
+                                    &reply, "sssi", user.c_str(),
+                                    remoteAddress.c_str(), type, ownerPid);
+        const char* sessionId = nullptr;
+        if (rc >= 0)
+        {
+            rc = sd_bus_message_read(reply, "s", &sessionId);
+        }
+        const auto latency = Clock::now() - start;
+        if (rc >= 0)
+        {
+            ids.emplace_back(sessionId);
+            sendReport(reportFd, OwnerReport::Kind::created, latency,
+                       sessionId);
+        }
+        else
+        {
+            sendReport(reportFd, OwnerReport::Kind::failed, latency, nullptr);
+        }
+        sd_bus_message_unref(reply);
+        sd_bus_error_free(&error);
+    }
+
+    // The front ends look the sessions of the user up between the requests.
+    {
+        sd_bus_error error = SD_BUS_ERROR_NULL;
+        sd_bus_message* reply = nullptr;
+        sd_bus_call_method(bus, serviceName, managerPath,
+                           obmc::dbus::session_manager::interface,
+                           "GetSessionsByUser", &error, &reply, "s",
+                           user.c_str());
+        sd_bus_message_unref(reply);
+        sd_bus_error_free(&error);
+    }
+
+    if (options.maxHoldMs != 0U)
+    {
+        ::usleep(static_cast<useconds_t>(random() % options.maxHoldMs) *
+                 1000U);
+    }
+
+    if (crash)
+    {
+        // Leave the sessions to the service reaper.
+        ::raise(SIGKILL);
+    }
+
+    for (const auto& id : ids)
+    {
+        sd_bus_error error = SD_BUS_ERROR_NULL;
+        const auto start = Clock::now();
+        const int rc =
+            sd_bus_call_method(bus, serviceName, managerPath,
+                               managerInterface, "Close", &error, nullptr,
+                               "s", id.c_str());
+        sendReport(reportFd,
+                   rc >= 0 ? OwnerReport::Kind::closed
+                           : OwnerReport::Kind::failed,
+                   Clock::now() - start, id.c_str());
+        sd_bus_error_free(&error);
+    }
+    sd_bus_flush_close_unref(bus);
+    ::_exit(EXIT_SUCCESS);
+}
+
+std::size_t residentSetKiB(pid_t pid)
+{
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.rfind("VmRSS:", 0) == 0)
+        {
+            return std::strtoull(line.c_str() + 6, nullptr, 10);
+        }
+    }
+    return 0U;
+}
+
+double percentileMs(Latencies& latencies, unsigned int rank)
+{
+    if (latencies.empty())
+    {
+        return 0.0;
+    }
+    const auto pos = (latencies.size() - 1U) * rank / 100U;
+    std::nth_element(latencies.begin(), latencies.begin() + pos,
+                     latencies.end());
+    return std::chrono::duration<double, std::milli>(latencies[pos]).count();
+}
+
+/**
+ * @brief Keeps the pool of fake owners busy and measures the service.
+ */
+class LoadGenerator
+{
+  public:
+    LoadGenerator(const LoadGenerator&) = delete;
+    LoadGenerator& operator=(const LoadGenerator&) = delete;
+    LoadGenerator(LoadGenerator&&) = delete;
+    LoadGenerator& operator=(LoadGenerator&&) = delete;
+
+    LoadGenerator(boost::asio::io_context& io,
+                  std::shared_ptr<sdbusplus::asio::connection> conn,
+                  const Options& options, const std::string& address,
+                  pid_t servicePid) :
+        io(io),
+        conn(std::move(conn)), options(options), address(address),
+        servicePid(servicePid), childSignals(io, SIGCHLD), reports(io),
+        reportTimer(io), pingTimer(io), stopTimer(io), spawning(true),
+        exitCode(EXIT_SUCCESS), seed(static_cast<unsigned int>(::getpid()))
+    {
+        std::array<int, 2> fds{};
+        if (::pipe2(fds.data(), O_CLOEXEC) < 0)
+        {
+            throw std::runtime_error("Failure to create the report pipe");
+        }
+        ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        reports.assign(fds[0]);
+        reportFd = fds[1];
+
+        changed = std::make_unique<sdbusplus::bus::match::match>(
+            *this->conn,
+            sdbusplus::bus::match::rules::type_signal() +
+                sdbusplus::bus::match::rules::member("SessionsChanged") +
+                sdbusplus::bus::match::rules::path(managerPath) +
+                sdbusplus::bus::match::rules::interface(
+                    obmc::dbus::session_manager::interface),
+            [this](sdbusplus::message::message& message) {
+                this->onSessionsChanged(message);
+            });
+    }
+
+    ~LoadGenerator()
+    {
+        ::close(reportFd);
+    }
+
+    int run()
+    {
+        started = Clock::now();
+        rssStart = residentSetKiB(servicePid);
+        waitChildren();
+        waitReports();
+        ping();
+        scheduleReport();
+        stopTimer.expires_after(options.duration);
+        stopTimer.async_wait([this](const boost::system::error_code& ec) {
+            if (!ec)
+            {
+                stopSpawning();
+            }
+        });
+        spawnOwners();
+
+        std::printf("%8s %8s %8s %8s %9s %9s %9s %9s %9s %9s %9s %10s\n",
+                    "time(s)", "owners", "sessions", "failed", "create50",
+                    "create99", "close50", "close99", "reap50", "reap99",
+                    "stall", "rss(KiB)");
+        io.run();
+        return exitCode;
+    }
+
+  private:
+    struct Session
+    {
+        pid_t owner;
+        Clock::time_point ownerExited;
+        Clock::time_point removed;
+    };
+
+    void spawnOwners()
+    {
+        while (spawning && owners.size() < options.concurrency)
+        {
+            io.notify_fork(boost::asio::io_context::fork_prepare);
+            const pid_t pid = ::fork();
+            if (pid == 0)
+            {
+                runOwner(address, reportFd, options, seed);
+            }
+            io.notify_fork(boost::asio::io_context::fork_parent);
+            if (pid < 0)
+            {
+                std::fprintf(stderr, "Failure to fork an owner: %s\n",
+                             std::strerror(errno));
+                break;
+            }
+            ++seed;
+            ++ownersSpawned;
+            owners[pid];
+        }
+    }
+
+    void stopSpawning()
+    {
+        spawning = false;
+        if (owners.empty())
+        {
+            settle();
+        }
+    }
+
+    void waitChildren()
+    {
+        childSignals.async_wait(
+            [this](const boost::system::error_code& ec, int) {
+                if (ec)
+                {
+                    return;
+                }
+                // Account all operations of the exited owners first.
+                drainReports();
+                pid_t pid;
+                int status;
+                while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0)
+                {
+                    ownerExited(pid);
+                }
+                if (stopping)
+                {
+                    return;
+                }
+                spawnOwners();
+                waitChildren();
+            });
+    }
+
+    void ownerExited(pid_t pid)
+    {
+        if (pid == servicePid)
+        {
+            std::fprintf(stderr, "The service has exited\n");
+            exitCode = EXIT_FAILURE;
+            stop();
+            return;
+        }
+        auto owner = owners.find(pid);
+        if (owner == owners.end())
+        {
+            return;
+        }
+        const auto now = Clock::now();
+        for (const auto& id : owner->second)
+        {
+            auto it = sessions.find(id);
+            if (it == sessions.end())
+            {
+                continue;
+            }
+            if (it->second.removed != Clock::time_point())
+            {
+                // The service has been faster than the wait of the loader.
+                reapLatencies.push_back(Clock::duration::zero());
+                sessions.erase(it);
+            }
+            else
+            {
+                it->second.ownerExited = now;
+            }
+        }
+        owners.erase(owner);
+        if (!spawning && owners.empty())
+        {
+            settle();
+        }
+    }
+
+    void waitReports()
+    {
+        reports.async_wait(boost::asio::posix::stream_descriptor::wait_read,
+                           [this](const boost::system::error_code& ec) {
+                               if (ec)
+                               {
+                                   return;
+                               }
+                               drainReports();
+                               waitReports();
+                           });
+    }
+
+    void drainReports()
+    {
+        OwnerReport report;
+        while (::read(reports.native_handle(), &report, sizeof(report)) ==
+               static_cast<ssize_t>(sizeof(report)))
+        {
+            const auto latency = std::chrono::microseconds(report.latencyUs);
+            report.sessionId.back() = '\0';
+            switch (report.kind)
+            {
+                case OwnerReport::Kind::created:
+                    createLatencies.push_back(latency);
+                    sessions.emplace(report.sessionId.data(),
+                                     Session{report.owner, {}, {}});
+                    owners[report.owner].emplace_back(
+                        report.sessionId.data());
+                    break;
+                case OwnerReport::Kind::closed:
+                    closeLatencies.push_back(latency);
+                    sessions.erase(report.sessionId.data());
+                    break;
+                case OwnerReport::Kind::failed:
+                    ++failures;
+                    break;
+            }
+        }
+    }
+
+    void onSessionsChanged(sdbusplus::message::message& message)
+    {
+        uint64_t generation = 0U;
+        std::vector<std::string> added;
+        std::vector<std::string> removed;
+        message.read(generation, added, removed);
+        // The session might be reported after the signal is received.
+        drainReports();
+        const auto now = Clock::now();
+        for (const auto& id : removed)
+        {
+            auto it = sessions.find(id);
+            if (it == sessions.end())
+            {
+                continue;
+            }
+            if (it->second.ownerExited != Clock::time_point())
+            {
+                const auto lag = now - it->second.ownerExited;
+                reapLatencies.push_back(lag);
+                maxReapLag = std::max(maxReapLag, lag);
+                sessions.erase(it);
+            }
+            else
+            {
+                it->second.removed = now;
+            }
+        }
+        if (stopping && pendingReaps() == 0U)
+        {
+            finish();
+        }
+    }
+
+    void ping()
+    {
+        const auto start = Clock::now();
+        conn->async_method_call(
+            [this, start](const boost::system::error_code& ec) {
+                if (stopping)
+                {
+                    return;
+                }
+                if (!ec)
+                {
+                    const auto stall = Clock::now() - start;
+                    pingLatencies.push_back(stall);
+                    maxStall = std::max(maxStall, stall);
+                }
+                pingTimer.expires_after(pingInterval);
+                pingTimer.async_wait(
+                    [this](const boost::system::error_code& ec) {
+                        if (!ec)
+                        {
+                            ping();
+                        }
+                    });
+            },
+            serviceName, managerPath, "org.freedesktop.DBus.Peer", "Ping");
+    }
+
+    void scheduleReport()
+    {
+        reportTimer.expires_after(options.reportInterval);
+        reportTimer.async_wait([this](const boost::system::error_code& ec) {
+            if (!ec)
+            {
+                report();
+                scheduleReport();
+            }
+        });
+    }
+
+    void report()
+    {
+        const auto rss = residentSetKiB(servicePid);
+        std::printf(
+            "%8.0f %8zu %8zu %8zu %9.2f %9.2f %9.2f %9.2f %9.1f %9.1f %9.1f "
+            "%10zu\n",
+            std::chrono::duration<double>(Clock::now() - started).count(),
+            ownersSpawned, sessions.size(), failures,
+            percentileMs(createLatencies, 50U),
+            percentileMs(createLatencies, 99U),
+            percentileMs(closeLatencies, 50U),
+            percentileMs(closeLatencies, 99U),
+            percentileMs(reapLatencies, 50U), percentileMs(reapLatencies, 99U),
+            percentileMs(pingLatencies, 100U), rss);
+        std::fflush(stdout);
+        createLatencies.clear();
+        closeLatencies.clear();
+        reapLatencies.clear();
+        pingLatencies.clear();
+    }
+
+    std::size_t pendingReaps() const
+    {
+        return static_cast<std::size_t>(
+            std::count_if(sessions.begin(), sessions.end(), [](const auto& s) {
+                return s.second.ownerExited != Clock::time_point();
+            }));
+    }
+
+    void settle()
+    {
+        stopping = true;
+        if (pendingReaps() == 0U)
+        {
+            finish();
+            return;
+        }
+        stopTimer.expires_after(settleTimeout);
+        stopTimer.async_wait([this](const boost::system::error_code& ec) {
+            if (!ec)
+            {
+                finish();
+            }
+        });
+    }
+
+    /**
+     * @brief Check the service has no session left once all owners are gone.
+     */
+    void finish()
+    {
+        if (finishing)
+        {
+            return;
+        }
+        finishing = true;
+        stopTimer.cancel();
+        conn->async_method_call(
+            [this](const boost::system::error_code& ec,
+                   const std::variant<std::map<std::string, uint64_t>>&
+                       value) {
+                report();
+                uint64_t left = 0U;
+                if (ec)
+                {
+                    std::fprintf(stderr, "Failure to read the statistics\n");
+                    exitCode = EXIT_FAILURE;
+                }
+                else
+                {
+                    for (const auto& [type, count] :
+                         std::get<std::map<std::string, uint64_t>>(value))
+                    {
+                        left += count;
+                    }
+                }
+                const auto rss = residentSetKiB(servicePid);
+                std::printf("owners: %zu, unreaped sessions: %zu, sessions "
+                            "left in the service: %llu\n",
+                            ownersSpawned, pendingReaps(),
+                            static_cast<unsigned long long>(left));
+                std::printf(
+                    "max reap lag: %.1f ms, max loop stall: %.1f ms, "
+                    "rss: %zu -> %zu KiB\n",
+                    std::chrono::duration<double, std::milli>(maxReapLag)
+                        .count(),
+                    std::chrono::duration<double, std::milli>(maxStall)
+                        .count(),
+                    rssStart, rss);
+                if (left != 0U || pendingReaps() != 0U)
+                {
+                    exitCode = EXIT_FAILURE;
+                }
+                stop();
+            },
+            serviceName, statsPath, "org.freedesktop.DBus.Properties", "Get",
+            obmc::dbus::session_stats::interface, "Sessions");
+    }
+
+    void stop()
+    {
+        stopping = true;
+        spawning = false;
+        for (const auto& [pid, ids] : owners)
+        {
+            ::kill(pid, SIGKILL);
+        }
+        io.stop();
+    }
+
+    boost::asio::io_context& io;
+    std::shared_ptr<sdbusplus::asio::connection> conn;
+    const Options& options;
+    const std::string& address;
+    const pid_t servicePid;
+    boost::asio::signal_set childSignals;
+    boost::asio::posix::stream_descriptor reports;
+    boost::asio::steady_timer reportTimer;
+    boost::asio::steady_timer pingTimer;
+    boost::asio::steady_timer stopTimer;
+    std::unique_ptr<sdbusplus::bus::match::match> changed;
+    int reportFd = -1;
+    bool spawning;
+    bool stopping = false;
+    bool finishing = false;
+    int exitCode;
+    unsigned int seed;
+    std::size_t ownersSpawned = 0U;
+    std::size_t failures = 0U;
+    std::size_t rssStart = 0U;
+    Clock::time_point started;
+    /** @brief Session IDs created by each running owner. */
+    std::unordered_map<pid_t, std::vector<std::string>> owners;
+    /** @brief Sessions the owners have created and not closed yet. */
+    std::unordered_map<std::string, Session> sessions;
+    Latencies createLatencies;
+    Latencies closeLatencies;
+    Latencies reapLatencies;
+    Latencies pingLatencies;
+    Clock::duration maxReapLag{};
+    Clock::duration maxStall{};
+};
+
+unsigned int parseNumber(const char* value)
+{
+    char* end = nullptr;
+    const auto number = std::strtoul(value, &end, 10);
+    if (end == value || *end != '\0' || number > UINT_MAX)
+    {
+        throw std::invalid_argument(std::string("Invalid number: ") + value);
+    }
+    return static_cast<unsigned int>(number);
+}
+
+void usage(const char* name)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [-d SECONDS] [-i SECONDS] [-c OWNERS] "
+                 "[-k PERCENT] [-n SESSIONS] [-t MILLISECONDS] SERVICE\n"
+                 "  -d  duration of the load (60)\n"
+                 "  -i  report interval (10)\n"
+                 "  -c  concurrent owner processes (64)\n"
+                 "  -k  percent of owners killed without closing (20)\n"
+                 "  -n  max sessions created by an owner (3)\n"
+                 "  -t  max time an owner holds its sessions (50)\n",
+                 name);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    try
+    {
+        int opt;
+        while ((opt = ::getopt(argc, argv, "d:i:c:k:n:t:")) != -1)
+        {
+            switch (opt)
+            {
+                case 'd':
+                    options.duration =
+                        std::chrono::seconds(parseNumber(optarg));
+                    break;
+                case 'i':
+                    options.reportInterval =
+                        std::chrono::seconds(parseNumber(optarg));
+                    break;
+                case 'c':
+                    options.concurrency = parseNumber(optarg);
+                    break;
+                case 'k':
+                    options.crashPercent = parseNumber(optarg);
+                    break;
+                case 'n':
+                    options.maxSessionsPerOwner = parseNumber(optarg);
+                    break;
+                case 't':
+                    options.maxHoldMs = parseNumber(optarg);
+                    break;
+                default:
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    if (optind + 1 != argc || options.concurrency == 0U ||
+        options.maxSessionsPerOwner == 0U ||
+        options.reportInterval.count() == 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    options.servicePath = argv[optind];
+
+    int rc = EXIT_FAILURE;
+    try
+    {
+        PrivateBus privateBus;
+        ServiceProcess service(options.servicePath, privateBus.getAddress());
+        service.waitReady();
+
+        boost::asio::io_context io;
+        auto conn = std::make_shared<sdbusplus::asio::connection>(
+            io, connectBus(privateBus.getAddress()));
+        LoadGenerator generator(io, conn, options, privateBus.getAddress(),
+                                service.getPid());
+        rc = generator.run();
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "Load generator failed: %s\n", e.what());
+    }
+    return rc;
+}
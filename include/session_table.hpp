@@ -0,0 +1,302 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace obmc
+{
+namespace session
+{
+namespace table
+{
+
+/**
+ * The session table published by the session manager.
+ *
+ * The table is an open-addressing hash table of the session IDs with linear
+ * probing, placed to a memory-mapped file. The service is the single writer:
+ * it makes the table sequence odd before a change and even after it, and the
+ * readers retry the lookup which overlapped a change (a seqlock). A lookup is
+ * a few memory loads and costs no system call.
+ *
+ * The table is complete unless the service has more sessions than fit in it;
+ * the lookup result is `unknown` when the table is incomplete, is being
+ * replaced or is not published at all, and the caller is expected to ask the
+ * service over D-Bus then.
+ */
+
+constexpr const char* defaultPath =
+    "/run/session-manager/sessions.table";
+constexpr uint32_t magic = 0x534d5354; // SMST
+constexpr uint32_t version = 1U;
+constexpr std::size_t maxUserNameLength = 48U;
+
+/** @brief The table holds every session of the service */
+constexpr uint32_t flagComplete = 1U << 0U;
+/** @brief The table is abandoned, the file was replaced by a new one */
+constexpr uint32_t flagRetired = 1U << 1U;
+
+struct Header
+{
+    uint32_t magic;
+    uint32_t version;
+    /** @brief Count of slots, the power of two */
+    uint32_t capacity;
+    uint32_t entrySize;
+    /** @brief The seqlock sequence, odd while the table is being changed */
+    uint32_t sequence;
+    uint32_t flags;
+    /** @brief Count of sessions in the table */
+    uint32_t count;
+    uint32_t reserved;
+};
+
+/**
+ * @brief The table slot. The user name is NUL-padded and is not
+ *        NUL-terminated when it fills the whole field.
+ */
+struct Entry
+{
+    /** @brief The session ID, 0 - the slot is empty */
+    uint64_t id;
+    int32_t ownerPid;
+    /** @brief The `xyz.openbmc_project.Session.Item.Type` value */
+    uint8_t type;
+    uint8_t reserved[3];
+    char userName[maxUserNameLength];
+};
+static_assert(sizeof(Header) == 32U);
+static_assert(sizeof(Entry) == 64U);
+
+/** @brief Get the file size of the table of the specified capacity. */
+inline std::size_t fileSize(uint32_t capacity)
+{
+    return sizeof(Header) + sizeof(Entry) * capacity;
+}
+
+/** @brief Get the slot to start probing for the session from. */
+inline uint32_t home(uint64_t id, uint32_t capacity)
+{
+    // The Fibonacci hashing spreads the sequential IDs over the table.
+    return static_cast<uint32_t>((id * 0x9e3779b97f4a7c15ULL) >> 32U) &
+           (capacity - 1U);
+}
+
+/**
+ * @brief Read-only view of the session table.
+ *
+ * The reader maps the table once and reopens it only if the service has
+ * replaced the file. An instance must not be used by several threads at once.
+ */
+class Reader
+{
+  public:
+    enum class Status
+    {
+        /** @brief The session exists */
+        valid,
+        /** @brief The session doesn't exist */
+        invalid,
+        /** @brief The table can't tell, ask the service */
+        unknown,
+    };
+
+    /** @brief The session properties found in the table. */
+    struct Session
+    {
+        uint64_t id;
+        pid_t ownerPid;
+        uint8_t type;
+        std::string_view userName() const
+        {
+            return std::string_view(name.data(),
+                                    ::strnlen(name.data(), name.size()));
+        }
+        std::array<char, maxUserNameLength> name;
+    };
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    Reader(Reader&&) = delete;
+    Reader& operator=(Reader&&) = delete;
+
+    /** @brief Maps the table. A table missing now is mapped on a lookup.
+     *
+     * @param[in] path  - the path of the table file
+     */
+    explicit Reader(const char* path = defaultPath) noexcept :
+        path(path), mapping(nullptr), size(0U), capacity(0U)
+    {
+        open();
+    }
+
+    ~Reader()
+    {
+        close();
+    }
+
+    /**
+     * @brief Look the session up.
+     *
+     * @param[in] id        - the session ID
+     * @param[out] session  - the session properties if it is valid
+     *
+     * @return Status   - whether the session exists
+     */
+    Status lookup(uint64_t id, Session& session) noexcept
+    {
+        if (mapping == nullptr || (flags() & flagRetired) != 0U)
+        {
+            // The service has replaced or has not published the table yet.
+            close();
+            if (!open())
+            {
+                return Status::unknown;
+            }
+        }
+        for (unsigned int attempt = 0U; attempt < maxAttempts; ++attempt)
+        {
+            const auto before = sequence().load(std::memory_order_acquire);
+            if ((before & 1U) != 0U)
+            {
+                continue;
+            }
+            const auto status = find(id, session);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence().load(std::memory_order_relaxed) == before)
+            {
+                return status;
+            }
+        }
+        // The service stopped amid the change or keeps changing the table.
+        return Status::unknown;
+    }
+
+    /** @brief Look the session up by the hex ID of the D-Bus API. */
+    Status lookup(std::string_view hexId, Session& session) noexcept
+    {
+        uint64_t id = 0U;
+        const auto end = hexId.data() + hexId.size();
+        const auto [ptr, ec] = std::from_chars(hexId.data(), end, id, 16);
+        if (ec != std::errc() || ptr != end || id == 0U)
+        {
+            return Status::invalid;
+        }
+        return lookup(id, session);
+    }
+
+  private:
+    static constexpr unsigned int maxAttempts = 1024U;
+
+    bool open() noexcept
+    {
+        const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        Header header{};
+        struct stat st
+        {};
+        if (::pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+            ::fstat(fd, &st) != 0 || header.magic != magic ||
+            header.version != version || header.entrySize != sizeof(Entry) ||
+            header.capacity == 0U ||
+            (header.capacity & (header.capacity - 1U)) != 0U ||
+            static_cast<std::size_t>(st.st_size) != fileSize(header.capacity))
+        {
+            ::close(fd);
+            return false;
+        }
+        void* newMapping = ::mmap(nullptr, fileSize(header.capacity),
+                                  PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (newMapping == MAP_FAILED)
+        {
+            return false;
+        }
+        mapping = newMapping;
+        size = fileSize(header.capacity);
+        capacity = header.capacity;
+        return true;
+    }
+
+    void close() noexcept
+    {
+        if (mapping != nullptr)
+        {
+            ::munmap(mapping, size);
+            mapping = nullptr;
+        }
+    }
+
+    Header& header() const noexcept
+    {
+        return *static_cast<Header*>(mapping);
+    }
+
+    std::atomic_ref<uint32_t> sequence() const noexcept
+    {
+        return std::atomic_ref<uint32_t>(header().sequence);
+    }
+
+    uint32_t flags() const noexcept
+    {
+        return std::atomic_ref<uint32_t>(header().flags).load(
+            std::memory_order_acquire);
+    }
+
+    /** @brief Probe the table, the result is valid if the sequence holds. */
+    Status find(uint64_t id, Session& session) const noexcept
+    {
+        if ((flags() & flagComplete) == 0U)
+        {
+            return Status::unknown;
+        }
+        const auto entries = reinterpret_cast<const Entry*>(
+            static_cast<const uint8_t*>(mapping) + sizeof(Header));
+        auto slot = home(id, capacity);
+        // A torn read may see no empty slot, so the probing is bounded.
+        for (uint32_t probed = 0U; probed < capacity; ++probed)
+        {
+            Entry entry;
+            std::memcpy(&entry, &entries[slot], sizeof(entry));
+            if (entry.id == 0U)
+            {
+                return Status::invalid;
+            }
+            if (entry.id == id)
+            {
+                session.id = entry.id;
+                session.ownerPid = entry.ownerPid;
+                session.type = entry.type;
+                std::memcpy(session.name.data(), entry.userName,
+                            session.name.size());
+                return Status::valid;
+            }
+            slot = (slot + 1U) & (capacity - 1U);
+        }
+        return Status::invalid;
+    }
+
+    const char* path;
+    void* mapping;
+    std::size_t size;
+    uint32_t capacity;
+};
+
+} // namespace table
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <activity.hpp>
+
+namespace obmc
+{
+namespace session
+{
+
+ActivityTracker::ActivityTracker(boost::asio::io_context& ioc,
+                                 std::chrono::seconds interval,
+                                 SessionStore& store, PublishHandler handler) :
+    store(store),
+    handler(std::move(handler)), timer(ioc), interval(interval)
+{}
+
+void ActivityTracker::touch(SessionRecord& record, uint64_t now)
+{
+    record.lastActivity = now;
+    if (record.activityPending)
+    {
+        return;
+    }
+    record.activityPending = true;
+    pending.push_back(record.id);
+    if (pending.size() > 1U)
+    {
+        return;
+    }
+    timer.expires_from_now(interval);
+    timer.async_wait([this](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        this->flush();
+    });
+}
+
+uint64_t ActivityTracker::now()
+{
+    const auto sinceEpoch =
+        std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch)
+            .count());
+}
+
+void ActivityTracker::flush()
+{
+    // The sessions closed since the touch are not in the table anymore.
+    std::vector<SessionIdentifier> published;
+    published.swap(pending);
+    for (const auto id : published)
+    {
+        auto record = store.find(id);
+        if (record != nullptr)
+        {
+            record->activityPending = false;
+            handler(*record);
+        }
+    }
+}
+
+} // namespace session
+} // namespace obmc
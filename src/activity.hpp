@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <session_store.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace obmc
+{
+namespace session
+{
+
+/**
+ * @brief Publishes the last activity time of sessions at a bounded rate.
+ *
+ * Touching a session only stamps its record. The first touch after the
+ * latest publication queues the session, and the queue is published by a
+ * timer armed for the configured interval, so a session emits at most one
+ * change per interval however often it is touched.
+ */
+class ActivityTracker
+{
+  public:
+    using PublishHandler = std::function<void(const SessionRecord&)>;
+
+    ActivityTracker() = delete;
+    ActivityTracker(const ActivityTracker&) = delete;
+    ActivityTracker& operator=(const ActivityTracker&) = delete;
+    ActivityTracker(ActivityTracker&&) = delete;
+    ActivityTracker& operator=(ActivityTracker&&) = delete;
+    ~ActivityTracker() = default;
+
+    /** @brief Constructs the activity tracker
+     *
+     * @param[in] ioc       - ASIO context
+     * @param[in] interval  - the minimal interval between the publications
+     *                        of a session
+     * @param[in] store     - the session table
+     * @param[in] handler   - the callback publishing the session activity
+     */
+    ActivityTracker(boost::asio::io_context& ioc,
+                    std::chrono::seconds interval, SessionStore& store,
+                    PublishHandler handler);
+
+    /**
+     * @brief Stamp the activity of the session and queue its publication.
+     *
+     * @param[in] record    - the record of the session
+     * @param[in] now       - the current time as returned by `now()`
+     */
+    void touch(SessionRecord& record, uint64_t now);
+
+    /** @brief Get the current realtime in microseconds since the epoch. */
+    static uint64_t now();
+
+  private:
+    void flush();
+
+    SessionStore& store;
+    PublishHandler handler;
+    boost::asio::steady_timer timer;
+    std::chrono::seconds interval;
+    std::vector<SessionIdentifier> pending;
+};
+
+} // namespace session
+} // namespace obmc
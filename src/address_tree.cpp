@@ -0,0 +1,322 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <arpa/inet.h>
+
+#include <address_tree.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+
+namespace obmc
+{
+namespace session
+{
+
+namespace
+{
+
+constexpr unsigned int ipv4MappedBits = 96U;
+
+/** @brief Parse the address, tell whether it was given as an IPv4 one. */
+std::optional<in6_addr> parse(std::string_view text, bool& ipv4)
+{
+    if (text.size() > 2U && text.front() == '[' && text.back() == ']')
+    {
+        text = text.substr(1U, text.size() - 2U);
+    }
+    text = text.substr(0U, text.find('%'));
+
+    std::array<char, INET6_ADDRSTRLEN> buffer;
+    if (text.empty() || text.size() >= buffer.size())
+    {
+        return std::nullopt;
+    }
+    std::memcpy(buffer.data(), text.data(), text.size());
+    buffer[text.size()] = '\0';
+
+    in6_addr address{};
+    in_addr ipv4Address;
+    if (::inet_pton(AF_INET, buffer.data(), &ipv4Address) == 1)
+    {
+        address.s6_addr[10] = 0xff;
+        address.s6_addr[11] = 0xff;
+        std::memcpy(&address.s6_addr[12], &ipv4Address, sizeof(ipv4Address));
+        ipv4 = true;
+        return address;
+    }
+    if (::inet_pton(AF_INET6, buffer.data(), &address) == 1)
+    {
+        ipv4 = false;
+        return address;
+    }
+    return std::nullopt;
+}
+
+unsigned int bit(const in6_addr& address, unsigned int index)
+{
+    return (address.s6_addr[index / 8U] >> (7U - index % 8U)) & 1U;
+}
+
+/**
+ * @brief Get count of the leading bits the addresses share, at most `limit`.
+ *        The bits before `from` are known to be equal.
+ */
+unsigned int commonLength(const in6_addr& a, const in6_addr& b,
+                          unsigned int from, unsigned int limit)
+{
+    for (auto byte = from / 8U; byte * 8U < limit; ++byte)
+    {
+        const uint8_t diff = a.s6_addr[byte] ^ b.s6_addr[byte];
+        if (diff != 0U)
+        {
+            return std::min(
+                byte * 8U + static_cast<unsigned int>(std::countl_zero(diff)),
+                limit);
+        }
+    }
+    return limit;
+}
+
+in6_addr masked(const in6_addr& address, unsigned int length)
+{
+    in6_addr result = address;
+    for (auto byte = length / 8U; byte < sizeof(result.s6_addr); ++byte)
+    {
+        const auto keep = byte == length / 8U ? length % 8U : 0U;
+        result.s6_addr[byte] &= static_cast<uint8_t>(0xff00U >> keep);
+    }
+    return result;
+}
+
+} // namespace
+
+std::optional<in6_addr> parseAddress(std::string_view text)
+{
+    bool ipv4 = false;
+    return parse(text, ipv4);
+}
+
+std::optional<Network> parseNetwork(std::string_view text)
+{
+    const auto slash = text.find('/');
+    bool ipv4 = false;
+    const auto address = parse(text.substr(0U, slash), ipv4);
+    if (!address)
+    {
+        return std::nullopt;
+    }
+
+    const unsigned int maxLength = ipv4 ? 32U : 128U;
+    unsigned int length = maxLength;
+    if (slash != std::string_view::npos)
+    {
+        const auto lengthText = text.substr(slash + 1U);
+        const auto end = lengthText.data() + lengthText.size();
+        const auto [ptr, ec] =
+            std::from_chars(lengthText.data(), end, length);
+        if (lengthText.empty() || ec != std::errc() || ptr != end ||
+            length > maxLength)
+        {
+            return std::nullopt;
+        }
+    }
+    if (ipv4)
+    {
+        length += ipv4MappedBits;
+    }
+    return Network{masked(*address, length), length};
+}
+
+std::string formatAddress(const in6_addr& address)
+{
+    std::array<char, INET6_ADDRSTRLEN> buffer;
+    const char* rendered =
+        IN6_IS_ADDR_V4MAPPED(&address)
+            ? ::inet_ntop(AF_INET, &address.s6_addr[12], buffer.data(),
+                          buffer.size())
+            : ::inet_ntop(AF_INET6, &address, buffer.data(), buffer.size());
+    return rendered != nullptr ? std::string(rendered) : std::string();
+}
+
+std::string normalizeAddress(const std::string& text)
+{
+    const auto address = parseAddress(text);
+    return address ? formatAddress(*address) : text;
+}
+
+AddressTree::AddressTree() : root(std::make_unique<Node>())
+{}
+
+AddressTree::~AddressTree() = default;
+
+void AddressTree::insert(const in6_addr& address, SessionIdentifier id)
+{
+    // The prefix grows along the path, so it is at most a node per bit long.
+    std::array<Node*, addressBits + 1U> path;
+    std::size_t depth = 0U;
+    Node* node = root.get();
+    while (true)
+    {
+        path[depth++] = node;
+        if (node->length == addressBits)
+        {
+            break;
+        }
+        auto& child = node->children[bit(address, node->length)];
+        if (!child)
+        {
+            child = std::make_unique<Node>();
+            child->prefix = address;
+            child->length = addressBits;
+        }
+        else
+        {
+            const auto common = commonLength(child->prefix, address,
+                                             node->length, child->length);
+            if (common < child->length)
+            {
+                // Fork the edge where the address leaves the child prefix.
+                auto fork = std::make_unique<Node>();
+                fork->prefix = masked(address, common);
+                fork->length = common;
+                fork->sessions = child->sessions;
+                const auto side = bit(child->prefix, common);
+                fork->children[side] = std::move(child);
+                child = std::move(fork);
+            }
+        }
+        node = child.get();
+    }
+
+    if (node->ids.insert(id).second)
+    {
+        for (std::size_t i = 0U; i < depth; ++i)
+        {
+            ++path[i]->sessions;
+        }
+    }
+}
+
+void AddressTree::erase(const in6_addr& address, SessionIdentifier id)
+{
+    std::array<std::unique_ptr<Node>*, addressBits + 1U> path;
+    std::size_t depth = 0U;
+    auto link = &root;
+    while (true)
+    {
+        path[depth++] = link;
+        Node* node = link->get();
+        if (node->length == addressBits)
+        {
+            break;
+        }
+        auto& child = node->children[bit(address, node->length)];
+        if (!child || commonLength(child->prefix, address, node->length,
+                                   child->length) < child->length)
+        {
+            return;
+        }
+        link = &child;
+    }
+
+    auto& leaf = *path[depth - 1U];
+    if (leaf->ids.erase(id) == 0U)
+    {
+        return;
+    }
+    for (std::size_t i = 0U; i < depth; ++i)
+    {
+        --(*path[i])->sessions;
+    }
+    if (!leaf->ids.empty())
+    {
+        return;
+    }
+
+    leaf.reset();
+    // The inner node left with a single child is replaced by that child.
+    if (depth > 2U)
+    {
+        auto& parent = *path[depth - 2U];
+        auto& children = parent->children;
+        auto remaining = std::move(children[0] ? children[0] : children[1]);
+        parent = std::move(remaining);
+    }
+}
+
+const SessionIdentifierSet* AddressTree::find(const in6_addr& address) const
+{
+    const Node* node = root.get();
+    while (node->length < addressBits)
+    {
+        const auto& child = node->children[bit(address, node->length)];
+        if (!child || commonLength(child->prefix, address, node->length,
+                                   child->length) < child->length)
+        {
+            return nullptr;
+        }
+        node = child.get();
+    }
+    return &node->ids;
+}
+
+std::vector<SessionIdentifier>
+    AddressTree::collect(const Network& network) const
+{
+    std::vector<SessionIdentifier> result;
+    const Node* top = cover(network);
+    if (top == nullptr)
+    {
+        return result;
+    }
+
+    result.reserve(top->sessions);
+    std::vector<const Node*> pending{top};
+    while (!pending.empty())
+    {
+        const Node* node = pending.back();
+        pending.pop_back();
+        result.insert(result.end(), node->ids.begin(), node->ids.end());
+        for (const auto& child : node->children)
+        {
+            if (child)
+            {
+                pending.push_back(child.get());
+            }
+        }
+    }
+    return result;
+}
+
+std::size_t AddressTree::count(const Network& network) const
+{
+    const Node* top = cover(network);
+    return top != nullptr ? top->sessions : 0U;
+}
+
+const AddressTree::Node* AddressTree::cover(const Network& network) const
+{
+    const Node* node = root.get();
+    while (node->length < network.length)
+    {
+        const auto& child = node->children[bit(network.prefix, node->length)];
+        if (!child)
+        {
+            return nullptr;
+        }
+        const auto limit = std::min(child->length, network.length);
+        if (commonLength(child->prefix, network.prefix, node->length,
+                         limit) < limit)
+        {
+            return nullptr;
+        }
+        node = child.get();
+    }
+    return node;
+}
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <netinet/in.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace obmc
+{
+namespace session
+{
+
+using SessionIdentifier = std::size_t;
+using SessionIdentifierSet = std::unordered_set<SessionIdentifier>;
+
+/**
+ * @brief The IP network: the address with the count of significant bits.
+ *        IPv4 networks are kept as IPv4-mapped IPv6 ones.
+ */
+struct Network
+{
+    in6_addr prefix;
+    unsigned int length;
+};
+
+/**
+ * @brief Parse the IPv4 or IPv6 address into the binary form.
+ *
+ * The IPv4 address is converted to the IPv4-mapped IPv6 one, so `10.0.0.1`
+ * and `::ffff:10.0.0.1` give the same address. The zone suffix (`%eth0`) and
+ * the square brackets around an IPv6 address are dropped.
+ *
+ * @param[in] text  - the address
+ *
+ * @return the binary address or nullopt if the text is not an IP address
+ */
+std::optional<in6_addr> parseAddress(std::string_view text);
+
+/**
+ * @brief Parse the network in the CIDR notation, e.g. `10.1.0.0/16` or
+ *        `fd00::/8`. An address without the prefix length is the network of
+ *        that single address. The bits beyond the prefix are ignored.
+ *
+ * @param[in] text  - the network
+ *
+ * @return the network or nullopt if the text is malformed
+ */
+std::optional<Network> parseNetwork(std::string_view text);
+
+/**
+ * @brief Render the address in the canonical form, IPv4-mapped addresses are
+ *        rendered as IPv4 ones.
+ */
+std::string formatAddress(const in6_addr& address);
+
+/**
+ * @brief Get the canonical form of the address, or the text itself if it is
+ *        not an IP address.
+ */
+std::string normalizeAddress(const std::string& text);
+
+/**
+ * @brief Path-compressed binary radix tree of sessions keyed by the remote
+ *        address.
+ *
+ * The leaves hold the sessions of an address, every inner node but the root
+ * has two children and keeps the count of sessions beneath it. Looking up an
+ * address or a network costs O(prefix length), collecting the sessions of a
+ * network costs O(matches) on top of it.
+ */
+class AddressTree
+{
+  public:
+    AddressTree();
+    AddressTree(const AddressTree&) = delete;
+    AddressTree& operator=(const AddressTree&) = delete;
+    AddressTree(AddressTree&&) = delete;
+    AddressTree& operator=(AddressTree&&) = delete;
+    ~AddressTree();
+
+    /** @brief Add the session of the address. */
+    void insert(const in6_addr& address, SessionIdentifier id);
+
+    /** @brief Remove the session of the address. */
+    void erase(const in6_addr& address, SessionIdentifier id);
+
+    /**
+     * @brief Get the sessions of the address.
+     *
+     * @return the sessions or nullptr if there are none
+     */
+    const SessionIdentifierSet* find(const in6_addr& address) const;
+
+    /** @brief Get the sessions of all addresses within the network. */
+    std::vector<SessionIdentifier> collect(const Network& network) const;
+
+    /** @brief Get count of sessions of all addresses within the network. */
+    std::size_t count(const Network& network) const;
+
+  private:
+    static constexpr unsigned int addressBits = 128U;
+
+    struct Node
+    {
+        /** @brief The prefix, the bits beyond the length are zeroed */
+        in6_addr prefix;
+        unsigned int length;
+        /** @brief Count of sessions in the subtree */
+        std::size_t sessions;
+        std::array<std::unique_ptr<Node>, 2> children;
+        /** @brief The sessions of the address, leaves only */
+        SessionIdentifierSet ids;
+    };
+
+    /** @brief Get the node covering the whole network, nullptr if none. */
+    const Node* cover(const Network& network) const;
+
+    std::unique_ptr<Node> root;
+};
+
+} // namespace session
+} // namespace obmc
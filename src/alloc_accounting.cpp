@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <alloc_accounting.hpp>
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+std::size_t allocationsCounter = 0U;
+
+void* allocate(std::size_t size)
+{
+    ++allocationsCounter;
+    if (void* ptr = std::malloc(size == 0U ? 1U : size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t align)
+{
+    ++allocationsCounter;
+    const auto alignment = static_cast<std::size_t>(align);
+    // The aligned_alloc requires the size to be a multiple of alignment.
+    const auto alignedSize = (size + alignment - 1U) / alignment * alignment;
+    if (void* ptr = std::aligned_alloc(alignment,
+                                       alignedSize == 0U ? alignment
+                                                         : alignedSize))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+} // namespace
+
+namespace obmc
+{
+namespace alloc
+{
+
+std::size_t allocations() noexcept
+{
+    return allocationsCounter;
+}
+
+} // namespace alloc
+} // namespace obmc
+
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    return allocateAligned(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    return allocateAligned(size, align);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
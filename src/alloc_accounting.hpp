@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <cstddef>
+
+namespace obmc
+{
+namespace alloc
+{
+
+/** @brief Accumulated heap allocations of an operation kind. */
+struct Stats
+{
+    std::size_t operations = 0U;
+    std::size_t allocations = 0U;
+};
+
+#ifdef SESSION_MANAGER_ALLOC_ACCOUNTING
+/**
+ * @brief Get count of heap allocations made by the process so far.
+ *
+ * @return std::size_t - the allocations counter
+ */
+std::size_t allocations() noexcept;
+#else
+inline std::size_t allocations() noexcept
+{
+    // The accounting is disabled in the production build.
+    return 0U;
+}
+#endif
+
+/**
+ * @brief Accounts heap allocations made within the scope as a single
+ *        operation.
+ */
+class Scope
+{
+  public:
+    Scope() = delete;
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    Scope(Scope&&) = delete;
+    Scope& operator=(Scope&&) = delete;
+
+    explicit Scope(Stats& stats) noexcept :
+        stats(stats), initial(allocations())
+    {}
+
+    ~Scope()
+    {
+        ++stats.operations;
+        stats.allocations += allocations() - initial;
+    }
+
+  private:
+    Stats& stats;
+    std::size_t initial;
+};
+
+} // namespace alloc
+} // namespace obmc
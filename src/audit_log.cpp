@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <audit_log.hpp>
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+namespace obmc
+{
+namespace session
+{
+
+using namespace phosphor::logging;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+template <std::size_t size>
+void copyField(char (&field)[size], std::string_view value)
+{
+    const auto length = std::min(value.size(), size);
+    std::memcpy(field, value.data(), length);
+    std::memset(field + length, 0, size - length);
+}
+} // namespace
+
+AuditLog::AuditLog(const std::string& path, uint32_t capacity) :
+    fd(-1), mapping(nullptr), capacity(0U), sequence(0U)
+{
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        log<level::ERR>("Failure to open the audit log",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+        return;
+    }
+
+    Header header{};
+    struct stat st
+    {};
+    const bool valid =
+        ::pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+        ::fstat(fd, &st) == 0 && header.magic == magic &&
+        header.version == version && header.capacity == capacity &&
+        header.recordSize == sizeof(Record) &&
+        static_cast<std::size_t>(st.st_size) == fileSize(capacity);
+    // The file of another layout is started over with zeroed records.
+    if (!valid &&
+        (::ftruncate(fd, 0) != 0 ||
+         ::ftruncate(fd, static_cast<off_t>(fileSize(capacity))) != 0))
+    {
+        log<level::ERR>("Failure to allocate the audit log",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+        return;
+    }
+    if (!map(fd, capacity))
+    {
+        log<level::ERR>("Failure to map the audit log",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+        return;
+    }
+
+    if (valid)
+    {
+        for (uint32_t slot = 0U; slot < capacity; ++slot)
+        {
+            sequence = std::max(sequence, records()[slot].sequence);
+        }
+    }
+    else
+    {
+        // The magic is written last, so a reader never sees a partial header.
+        auto mappedHeader = static_cast<Header*>(mapping);
+        mappedHeader->version = version;
+        mappedHeader->capacity = capacity;
+        mappedHeader->recordSize = sizeof(Record);
+        std::atomic_ref<uint32_t>(mappedHeader->magic)
+            .store(magic, std::memory_order_release);
+    }
+}
+
+AuditLog::~AuditLog()
+{
+    if (mapping != nullptr)
+    {
+        ::munmap(mapping, fileSize(capacity));
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+}
+
+void AuditLog::record(Event event, std::string_view cause,
+                      SessionIdentifier id, std::string_view userName,
+                      std::string_view remoteAddress, uint8_t type,
+                      pid_t ownerPid)
+{
+    if (mapping == nullptr)
+    {
+        return;
+    }
+
+    const auto current = ++sequence;
+    auto& record = records()[current % capacity];
+    std::atomic_ref<uint64_t> recordSequence(record.sequence);
+    // Invalidate the overwritten record before its fields are touched.
+    recordSequence.store(0U, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const auto sinceEpoch =
+        std::chrono::system_clock::now().time_since_epoch();
+    record.timestamp = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch)
+            .count());
+    record.id = id;
+    record.ownerPid = ownerPid;
+    record.event = event;
+    record.type = type;
+    copyField(record.cause, cause);
+    copyField(record.userName, userName);
+    copyField(record.remoteAddress, remoteAddress);
+
+    recordSequence.store(current, std::memory_order_release);
+}
+
+std::size_t AuditLog::fileSize(uint32_t capacity)
+{
+    return sizeof(Header) + sizeof(Record) * capacity;
+}
+
+bool AuditLog::map(int fd, uint32_t capacity)
+{
+    void* newMapping = ::mmap(nullptr, fileSize(capacity),
+                              PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (newMapping == MAP_FAILED)
+    {
+        return false;
+    }
+    mapping = newMapping;
+    this->capacity = capacity;
+    return true;
+}
+
+AuditLog::Record* AuditLog::records() const
+{
+    return reinterpret_cast<Record*>(static_cast<uint8_t*>(mapping) +
+                                     sizeof(Header));
+}
+
+} // namespace session
+} // namespace obmc
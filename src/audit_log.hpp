@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace obmc
+{
+namespace session
+{
+
+using SessionIdentifier = std::size_t;
+
+/**
+ * @brief Memory-mapped ring of the session audit records.
+ *
+ * Every session creation, removal and rejected creation is written to a
+ * fixed-size slot of the memory-mapped file with plain memory stores, so
+ * recording an event costs no system call. The slot is claimed by zeroing its
+ * sequence number and committed by storing the sequence number last, which
+ * lets the readers skip a record being overwritten. The oldest records are
+ * overwritten when the ring is full. The ring survives the service restarts:
+ * a valid file of the same layout is continued from its latest record.
+ */
+class AuditLog
+{
+  public:
+    static constexpr const char* defaultPath =
+        "/run/session-manager/audit.ring";
+    static constexpr uint32_t magic = 0x534d4152; // SMAR
+    static constexpr uint32_t version = 1U;
+    static constexpr uint32_t defaultCapacity = 8192U;
+    static constexpr std::size_t maxCauseLength = 20U;
+    static constexpr std::size_t maxUserNameLength = 32U;
+    static constexpr std::size_t maxRemoteAddressLength = 44U;
+
+    enum class Event : uint8_t
+    {
+        created = 1U,
+        closed = 2U,
+        rejected = 3U,
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t recordSize;
+    };
+
+    /**
+     * @brief The audit record. The text fields are NUL-padded and are not
+     *        NUL-terminated when they fill the whole field.
+     */
+    struct Record
+    {
+        /** @brief Sequence number of the record, 0 - the slot is empty */
+        uint64_t sequence;
+        /** @brief Realtime of the event, microseconds since the epoch */
+        uint64_t timestamp;
+        uint64_t id;
+        int32_t ownerPid;
+        Event event;
+        /** @brief The `xyz.openbmc_project.Session.Item.Type` value */
+        uint8_t type;
+        uint8_t reserved[2];
+        char cause[maxCauseLength];
+        char userName[maxUserNameLength];
+        char remoteAddress[maxRemoteAddressLength];
+    };
+    static_assert(sizeof(Header) == 16U);
+    static_assert(sizeof(Record) == 128U);
+
+    AuditLog() = delete;
+    AuditLog(const AuditLog&) = delete;
+    AuditLog& operator=(const AuditLog&) = delete;
+    AuditLog(AuditLog&&) = delete;
+    AuditLog& operator=(AuditLog&&) = delete;
+
+    /** @brief Opens or creates the audit ring. The audit is disabled if the
+     *         file can't be mapped.
+     *
+     * @param[in] path      - the path of the ring file
+     * @param[in] capacity  - count of the records kept in the ring
+     */
+    explicit AuditLog(const std::string& path,
+                      uint32_t capacity = defaultCapacity);
+    ~AuditLog();
+
+    /**
+     * @brief Write the event to the ring.
+     *
+     * @param[in] event         - the kind of the event
+     * @param[in] cause         - the operation causing the event
+     * @param[in] id            - the session ID, 0 for a rejected creation
+     * @param[in] userName      - the session owner user name
+     * @param[in] remoteAddress - the session remote address
+     * @param[in] type          - the session type
+     * @param[in] ownerPid      - the session owner PID
+     */
+    void record(Event event, std::string_view cause, SessionIdentifier id,
+                std::string_view userName, std::string_view remoteAddress,
+                uint8_t type, pid_t ownerPid);
+
+    /** @brief Get the file size of the ring of the specified capacity. */
+    static std::size_t fileSize(uint32_t capacity);
+
+  private:
+    bool map(int fd, uint32_t capacity);
+    Record* records() const;
+
+    int fd;
+    void* mapping;
+    uint32_t capacity;
+    uint64_t sequence;
+};
+
+} // namespace session
+} // namespace obmc
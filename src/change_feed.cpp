@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <change_feed.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+namespace obmc
+{
+namespace session
+{
+
+namespace
+{
+ChangeFeed::Generation initialGeneration()
+{
+    const auto sinceEpoch =
+        std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<ChangeFeed::Generation>(
+        std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch)
+            .count());
+}
+
+ChangeFeed::SessionIdentifierList toList(const SessionIdentifierSet& ids)
+{
+    return ChangeFeed::SessionIdentifierList(ids.begin(), ids.end());
+}
+} // namespace
+
+ChangeFeed::ChangeFeed(boost::asio::io_context& ioc, EmitHandler handler,
+                       std::size_t capacity) :
+    handler(std::move(handler)),
+    timer(ioc), ring(std::max<std::size_t>(capacity, 1U)),
+    generation(initialGeneration()), flushScheduled(false)
+{
+    firstGeneration = generation + 1U;
+}
+
+void ChangeFeed::added(SessionIdentifier id)
+{
+    merge(pendingAdded, pendingRemoved, id, true);
+    scheduleFlush();
+}
+
+void ChangeFeed::removed(SessionIdentifier id)
+{
+    merge(pendingAdded, pendingRemoved, id, false);
+    scheduleFlush();
+}
+
+void ChangeFeed::merge(SessionIdentifierSet& added,
+                       SessionIdentifierSet& removed, SessionIdentifier id,
+                       bool isAdded)
+{
+    // The session IDs are never reused, so a session added and removed
+    // within the merged range is not reported at all.
+    if (isAdded)
+    {
+        added.insert(id);
+    }
+    else if (added.erase(id) == 0U)
+    {
+        removed.insert(id);
+    }
+}
+
+void ChangeFeed::scheduleFlush()
+{
+    if (flushScheduled)
+    {
+        return;
+    }
+    flushScheduled = true;
+    timer.expires_from_now(std::chrono::seconds(0));
+    timer.async_wait([this](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        flushScheduled = false;
+        flush();
+    });
+}
+
+void ChangeFeed::flush()
+{
+    if (pendingAdded.empty() && pendingRemoved.empty())
+    {
+        return;
+    }
+
+    ++generation;
+    auto& delta = ring[generation % ring.size()];
+    delta.added = toList(pendingAdded);
+    delta.removed = toList(pendingRemoved);
+    pendingAdded.clear();
+    pendingRemoved.clear();
+    handler(generation, delta.added, delta.removed);
+}
+
+ChangeFeed::Generation ChangeFeed::getGeneration() const
+{
+    return generation;
+}
+
+bool ChangeFeed::changesSince(Generation since, SessionIdentifierList& added,
+                              SessionIdentifierList& removed) const
+{
+    const Generation recorded = generation + 1U - firstGeneration;
+    const Generation oldest =
+        generation + 1U - std::min<Generation>(recorded, ring.size());
+    if (since > generation || since + 1U < oldest)
+    {
+        return false;
+    }
+
+    SessionIdentifierSet addedSet;
+    SessionIdentifierSet removedSet;
+    for (auto current = since + 1U; current <= generation; ++current)
+    {
+        const auto& delta = ring[current % ring.size()];
+        for (const auto id : delta.added)
+        {
+            merge(addedSet, removedSet, id, true);
+        }
+        for (const auto id : delta.removed)
+        {
+            merge(addedSet, removedSet, id, false);
+        }
+    }
+    added = toList(addedSet);
+    removed = toList(removedSet);
+    return true;
+}
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <session_index.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace obmc
+{
+namespace session
+{
+
+/**
+ * @brief Sequence-numbered feed of the session table changes.
+ *
+ * The changes made within a single event loop turn are coalesced into one
+ * delta, which bumps the generation number, gets reported to the emit handler
+ * and is kept in a bounded ring for the clients catching up. The generation
+ * starts from the realtime clock in microseconds, so it keeps growing across
+ * the service restarts and a stale generation of the previous instance is
+ * never mistaken for the current one.
+ */
+class ChangeFeed
+{
+  public:
+    using Generation = uint64_t;
+    using SessionIdentifierList = std::vector<SessionIdentifier>;
+    using EmitHandler =
+        std::function<void(Generation, const SessionIdentifierList& added,
+                           const SessionIdentifierList& removed)>;
+
+    /** @brief Count of the latest deltas kept for the clients catching up */
+    static constexpr std::size_t defaultCapacity = 256U;
+
+    ChangeFeed() = delete;
+    ChangeFeed(const ChangeFeed&) = delete;
+    ChangeFeed& operator=(const ChangeFeed&) = delete;
+    ChangeFeed(ChangeFeed&&) = delete;
+    ChangeFeed& operator=(ChangeFeed&&) = delete;
+    ~ChangeFeed() = default;
+
+    /** @brief Constructs the change feed
+     *
+     * @param[in] ioc       - ASIO context
+     * @param[in] handler   - the callback to invoke for each delta
+     * @param[in] capacity  - count of the latest deltas to keep
+     */
+    ChangeFeed(boost::asio::io_context& ioc, EmitHandler handler,
+               std::size_t capacity = defaultCapacity);
+
+    /** @brief Record the session has been added. */
+    void added(SessionIdentifier id);
+
+    /** @brief Record the session has been removed. */
+    void removed(SessionIdentifier id);
+
+    /** @brief Turn the pending changes into a delta right now. */
+    void flush();
+
+    /** @brief Get the generation of the latest delta. */
+    Generation getGeneration() const;
+
+    /**
+     * @brief Collect the changes made after the specified generation.
+     *
+     * @param[in] since     - the generation the client is in sync with
+     * @param[out] added    - the sessions added since the generation
+     * @param[out] removed  - the sessions removed since the generation
+     *
+     * @return false if the deltas since the generation are not kept anymore
+     *         and the client has to take a full snapshot.
+     */
+    bool changesSince(Generation since, SessionIdentifierList& added,
+                      SessionIdentifierList& removed) const;
+
+  private:
+    struct Delta
+    {
+        SessionIdentifierList added;
+        SessionIdentifierList removed;
+    };
+
+    /** @brief Apply the change to the coalesced sets of changes. */
+    static void merge(SessionIdentifierSet& added,
+                      SessionIdentifierSet& removed, SessionIdentifier id,
+                      bool isAdded);
+
+    void scheduleFlush();
+
+    EmitHandler handler;
+    boost::asio::steady_timer timer;
+    std::vector<Delta> ring;
+    Generation firstGeneration;
+    Generation generation;
+    SessionIdentifierSet pendingAdded;
+    SessionIdentifierSet pendingRemoved;
+    bool flushScheduled;
+};
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <config.hpp>
+#include <phosphor-logging/log.hpp>
+
+#include <charconv>
+#include <fstream>
+
+namespace obmc
+{
+namespace session
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+constexpr const char* sessionTypePrefix =
+    "xyz.openbmc_project.Session.Item.Type.";
+
+std::string trim(const std::string& str)
+{
+    const auto first = str.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+    {
+        return std::string();
+    }
+    const auto last = str.find_last_not_of(" \t\r");
+    return str.substr(first, last - first + 1);
+}
+
+template <typename Duration>
+bool parseDuration(const std::string& value, Duration& result)
+{
+    uint64_t count = 0U;
+    const auto end = value.data() + value.size();
+    const auto [ptr, ec] = std::from_chars(value.data(), end, count);
+    if (ec != std::errc() || ptr != end)
+    {
+        return false;
+    }
+    result = Duration(count);
+    return true;
+}
+
+bool parseCount(const std::string& value, std::size_t& result)
+{
+    const auto end = value.data() + value.size();
+    const auto [ptr, ec] = std::from_chars(value.data(), end, result);
+    return ec == std::errc() && ptr == end;
+}
+
+bool parseBool(const std::string& value, bool& result)
+{
+    if (value == "true" || value == "yes" || value == "1")
+    {
+        result = true;
+        return true;
+    }
+    if (value == "false" || value == "no" || value == "0")
+    {
+        result = false;
+        return true;
+    }
+    return false;
+}
+
+bool parseRate(const std::string& value, double& result,
+               double minimum = 0.0)
+{
+    double rate = 0.0;
+    const auto end = value.data() + value.size();
+    const auto [ptr, ec] = std::from_chars(value.data(), end, rate);
+    if (ec != std::errc() || ptr != end || !(rate >= minimum))
+    {
+        return false;
+    }
+    result = rate;
+    return true;
+}
+
+bool parseBurst(const std::string& value, double& result)
+{
+    // A bucket holding less than a token never lets a session through.
+    return parseRate(value, result, 1.0);
+}
+} // namespace
+
+Config Config::load(const std::string& path)
+{
+    Config config;
+
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        return config;
+    }
+
+    std::string section;
+    std::string line;
+    std::size_t lineNumber = 0U;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        line = trim(line);
+        if (line.empty() || line.front() == '#' || line.front() == ';')
+        {
+            continue;
+        }
+        if (line.front() == '[' && line.back() == ']')
+        {
+            section = trim(line.substr(1, line.size() - 2));
+            continue;
+        }
+        const auto delimiter = line.find('=');
+        if (delimiter == std::string::npos ||
+            !config.apply(section, trim(line.substr(0, delimiter)),
+                          trim(line.substr(delimiter + 1))))
+        {
+            log<level::WARNING>("Ignore malformed configuration setting",
+                                entry("PATH=%s", path.c_str()),
+                                entry("LINE=%zu", lineNumber));
+        }
+    }
+    return config;
+}
+
+const SessionTypeConfig& Config::forType(SessionType type) const
+{
+    static const SessionTypeConfig defaultConfig;
+    auto found = types.find(type);
+    return found == types.end() ? defaultConfig : found->second;
+}
+
+const LimitsConfig& Config::getLimits() const
+{
+    return limits;
+}
+
+const ServiceConfig& Config::getService() const
+{
+    return service;
+}
+
+bool Config::apply(const std::string& section, const std::string& key,
+                   const std::string& value)
+{
+    if (section == "Service")
+    {
+        if (key == "VirtualObjects")
+        {
+            return parseBool(value, service.virtualObjects);
+        }
+        if (key == "AllowUnknownUsers")
+        {
+            return parseBool(value, service.allowUnknownUsers);
+        }
+        if (key == "ActivityInterval")
+        {
+            return parseDuration(value, service.activityInterval);
+        }
+        if (key == "SlowHandlerThreshold")
+        {
+            return parseDuration(value, service.slowHandlerThreshold);
+        }
+        if (key == "SessionTableCapacity")
+        {
+            return parseCount(value, service.sessionTableCapacity);
+        }
+        return false;
+    }
+
+    if (section == "Limits")
+    {
+        if (key == "MaxSessionsPerUser")
+        {
+            return parseCount(value, limits.maxSessionsPerUser);
+        }
+        if (key == "MaxSessionsPerAddress")
+        {
+            return parseCount(value, limits.maxSessionsPerAddress);
+        }
+        if (key == "CreateRatePerUser")
+        {
+            return parseRate(value, limits.createRatePerUser.rate);
+        }
+        if (key == "CreateBurstPerUser")
+        {
+            return parseBurst(value, limits.createRatePerUser.burst);
+        }
+        if (key == "CreateRatePerAddress")
+        {
+            return parseRate(value, limits.createRatePerAddress.rate);
+        }
+        if (key == "CreateBurstPerAddress")
+        {
+            return parseBurst(value, limits.createRatePerAddress.burst);
+        }
+        return false;
+    }
+
+    SessionType type;
+    try
+    {
+        type = sdbusplus::xyz::openbmc_project::Session::server::Item::
+            convertTypeFromString(sessionTypePrefix + section);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+
+    auto& typeConfig = types[type];
+    if (key == "IdleTimeout")
+    {
+        return parseDuration(value, typeConfig.idleTimeout);
+    }
+    if (key == "AbsoluteTimeout")
+    {
+        return parseDuration(value, typeConfig.absoluteTimeout);
+    }
+    if (key == "MaxSessions")
+    {
+        return parseCount(value, typeConfig.maxSessions);
+    }
+    if (key == "CreateRate")
+    {
+        return parseRate(value, typeConfig.createRate.rate);
+    }
+    if (key == "CreateBurst")
+    {
+        return parseBurst(value, typeConfig.createRate.burst);
+    }
+    return false;
+}
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <xyz/openbmc_project/Session/Item/server.hpp>
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+namespace obmc
+{
+namespace session
+{
+
+/** @brief Token bucket settings of the session creation rate limit */
+struct RateLimit
+{
+    /** @brief Sessions allowed to create per second, 0 - unlimited */
+    double rate = 0.0;
+    /** @brief Sessions allowed to create at once */
+    double burst = 1.0;
+};
+
+/** @brief Settings applied to the sessions of a particular type */
+struct SessionTypeConfig
+{
+    /** @brief Close the session if it isn't used for this time, 0 - never */
+    std::chrono::seconds idleTimeout{0};
+    /** @brief Close the session after this time since creation, 0 - never */
+    std::chrono::seconds absoluteTimeout{0};
+    /** @brief Maximum concurrent sessions of the type, 0 - unlimited */
+    std::size_t maxSessions = 0U;
+    /** @brief Creation rate limit of the type sessions */
+    RateLimit createRate;
+};
+
+/** @brief Settings of the service itself */
+struct ServiceConfig
+{
+    /** @brief Serve the session objects from the session table */
+    bool virtualObjects = false;
+    /** @brief Allow sessions of users unknown to the user manager */
+    bool allowUnknownUsers = false;
+    /** @brief Minimal interval between LastActivity updates of a session */
+    std::chrono::seconds activityInterval{1};
+    /** @brief The event loop lag or handler duration to log, 0 - any */
+    std::chrono::milliseconds slowHandlerThreshold{100};
+    /** @brief Initial count of the shared session table slots */
+    std::size_t sessionTableCapacity = 4096U;
+};
+
+/** @brief Limits applied to each user and remote address */
+struct LimitsConfig
+{
+    /** @brief Maximum concurrent sessions of a user, 0 - unlimited */
+    std::size_t maxSessionsPerUser = 0U;
+    /** @brief Maximum concurrent sessions of an address, 0 - unlimited */
+    std::size_t maxSessionsPerAddress = 0U;
+    /** @brief Creation rate limit of a user sessions */
+    RateLimit createRatePerUser;
+    /** @brief Creation rate limit of an address sessions */
+    RateLimit createRatePerAddress;
+};
+
+/**
+ * @brief The session manager configuration.
+ *
+ * The configuration file consists of the `Service` and `Limits` sections and
+ * sections named after the session types (the last segment of
+ * `xyz.openbmc_project.Session.Item.Type` values):
+ * @code
+ * [Service]
+ * VirtualObjects=true
+ * AllowUnknownUsers=false
+ * ActivityInterval=5
+ * SlowHandlerThreshold=100
+ * SessionTableCapacity=4096
+ *
+ * [Limits]
+ * MaxSessionsPerUser=16
+ * CreateRatePerAddress=5
+ * CreateBurstPerAddress=10
+ *
+ * [Redfish]
+ * IdleTimeout=1800
+ * AbsoluteTimeout=86400
+ * MaxSessions=64
+ * @endcode
+ * All durations are in seconds except `SlowHandlerThreshold`, which is in
+ * milliseconds; rates are in sessions per second. A missing file or setting
+ * keeps the default.
+ */
+class Config
+{
+  public:
+    using SessionType =
+        sdbusplus::xyz::openbmc_project::Session::server::Item::Type;
+
+    static constexpr const char* defaultPath = "/etc/session-manager.conf";
+
+    /**
+     * @brief Load the configuration from the file. Malformed settings are
+     *        reported to the journal and ignored.
+     *
+     * @param path      - the configuration file path
+     *
+     * @return Config   - the loaded configuration
+     */
+    static Config load(const std::string& path);
+
+    /**
+     * @brief Get the settings of the specified session type.
+     */
+    const SessionTypeConfig& forType(SessionType type) const;
+
+    /**
+     * @brief Get the per user and per address limits.
+     */
+    const LimitsConfig& getLimits() const;
+
+    /**
+     * @brief Get the settings of the service.
+     */
+    const ServiceConfig& getService() const;
+
+  private:
+    bool apply(const std::string& section, const std::string& key,
+               const std::string& value);
+
+    std::unordered_map<SessionType, SessionTypeConfig> types;
+    LimitsConfig limits;
+    ServiceConfig service;
+};
+
+} // namespace session
+} // namespace obmc
@@ -27,6 +27,73 @@ constexpr const char* getObject = "GetObject";
 constexpr const char* getSubTree = "GetSubTree";
 constexpr const char* getSubTreePaths = "GetSubTreePaths";
 } // namespace object_mapper
+namespace session_manager
+{
+constexpr const char* interface = "com.yadro.Session.Manager";
+
+namespace error
+{
+struct QuotaExceeded final : public sdbusplus::exception_t
+{
+    static constexpr auto errName = "com.yadro.Session.Error.QuotaExceeded";
+    static constexpr auto errDesc =
+        "The limit of concurrent sessions has been reached.";
+    static constexpr auto errWhat =
+        "com.yadro.Session.Error.QuotaExceeded: "
+        "The limit of concurrent sessions has been reached.";
+
+    const char* name() const noexcept override
+    {
+        return errName;
+    }
+    const char* description() const noexcept override
+    {
+        return errDesc;
+    }
+    const char* what() const noexcept override
+    {
+        return errWhat;
+    }
+};
+
+struct RateLimited final : public sdbusplus::exception_t
+{
+    static constexpr auto errName = "com.yadro.Session.Error.RateLimited";
+    static constexpr auto errDesc =
+        "Sessions are created too often, retry later.";
+    static constexpr auto errWhat =
+        "com.yadro.Session.Error.RateLimited: "
+        "Sessions are created too often, retry later.";
+
+    const char* name() const noexcept override
+    {
+        return errName;
+    }
+    const char* description() const noexcept override
+    {
+        return errDesc;
+    }
+    const char* what() const noexcept override
+    {
+        return errWhat;
+    }
+};
+} // namespace error
+} // namespace session_manager
+namespace session_stats
+{
+constexpr const char* interface = "com.yadro.Session.Stats";
+} // namespace session_stats
+namespace session_item
+{
+constexpr const char* interface = "com.yadro.Session.Item";
+} // namespace session_item
+namespace user_manager
+{
+constexpr const char* interface = "xyz.openbmc_project.User.Manager";
+constexpr const char* attributesIface = "xyz.openbmc_project.User.Attributes";
+constexpr const char* root = "/xyz/openbmc_project/user";
+} // namespace user_manager
 namespace freedesktop
 {
 constexpr const char* propertyIface = "org.freedesktop.DBus.Properties";
@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <journal.hpp>
+#include <phosphor-logging/log.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+namespace obmc
+{
+namespace session
+{
+
+using namespace phosphor::logging;
+using namespace std::chrono_literals;
+
+namespace fs = std::filesystem;
+
+SessionJournal::SessionJournal(boost::asio::io_context& ioc,
+                               std::string path) :
+    ioc(ioc),
+    compactionTimer(ioc), path(std::move(path)), fd(-1), mapping(nullptr),
+    capacity(0U), tail(0U), compactionScheduled(false)
+{}
+
+SessionJournal::~SessionJournal()
+{
+    unmap();
+}
+
+std::vector<SessionJournal::Entry> SessionJournal::load()
+{
+    std::vector<Entry> entries;
+
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    const int journalFd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (journalFd >= 0)
+    {
+        Header header{};
+        struct stat st
+        {};
+        const bool valid =
+            ::pread(journalFd, &header, sizeof(header), 0) ==
+                sizeof(header) &&
+            ::fstat(journalFd, &st) == 0 && header.magic == journalMagic &&
+            header.version == journalVersion &&
+            static_cast<std::size_t>(st.st_size) == fileSize(header.capacity);
+        if (valid && map(journalFd, header.capacity))
+        {
+            std::unordered_map<SessionIdentifier, uint32_t> slots;
+            for (tail = 0U; tail < capacity; ++tail)
+            {
+                auto& record = records()[tail];
+                const auto state = std::atomic_ref<uint32_t>(record.state)
+                                       .load(std::memory_order_acquire);
+                if (state == RecordState::added)
+                {
+                    slots[record.id] = tail;
+                }
+                else if (state == RecordState::removed)
+                {
+                    slots.erase(record.id);
+                }
+                else
+                {
+                    break;
+                }
+            }
+            liveSlots = std::move(slots);
+            for (const auto& [id, slot] : liveSlots)
+            {
+                const auto& record = records()[slot];
+                entries.push_back(
+                    {id, record.ownerPid, record.type,
+                     std::string(record.userName, record.userNameLength),
+                     std::string(record.remoteAddress,
+                                 record.remoteAddressLength)});
+            }
+            return entries;
+        }
+        ::close(journalFd);
+        log<level::WARNING>("Drop the malformed sessions journal",
+                            entry("PATH=%s", path.c_str()));
+    }
+
+    // Start with an empty journal.
+    compact();
+    return entries;
+}
+
+bool SessionJournal::append(SessionIdentifier id, const std::string& userName,
+                            const std::string& remoteAddress, uint8_t type,
+                            pid_t ownerPid)
+{
+    if (userName.size() > maxUserNameLength ||
+        remoteAddress.size() > maxRemoteAddressLength)
+    {
+        // The manager accepts any length, so the session is kept, but it
+        // won't be restored after the service restart.
+        log<level::WARNING>("The session doesn't fit the journal record",
+                            entry("SESSION_ID=%zx", id),
+                            entry("USER=%s", userName.c_str()),
+                            entry("REMOTE_ADDRESS=%s", remoteAddress.c_str()));
+        return false;
+    }
+
+    auto record = nextRecord();
+    if (record == nullptr)
+    {
+        return false;
+    }
+
+    record->ownerPid = ownerPid;
+    record->id = id;
+    record->type = type;
+    record->userNameLength = static_cast<uint8_t>(userName.size());
+    record->remoteAddressLength = static_cast<uint8_t>(remoteAddress.size());
+    std::memcpy(record->userName, userName.data(), userName.size());
+    std::memcpy(record->remoteAddress, remoteAddress.data(),
+                remoteAddress.size());
+    liveSlots[id] = static_cast<uint32_t>(record - records());
+    commit(*record, RecordState::added);
+    return true;
+}
+
+void SessionJournal::remove(SessionIdentifier id)
+{
+    if (liveSlots.erase(id) == 0U)
+    {
+        return;
+    }
+
+    auto record = nextRecord();
+    if (record == nullptr)
+    {
+        return;
+    }
+    record->id = id;
+    commit(*record, RecordState::removed);
+}
+
+bool SessionJournal::compact()
+{
+    compactionScheduled = false;
+
+    const auto liveCount = static_cast<uint32_t>(liveSlots.size());
+    const auto newCapacity = std::max(minCapacity, liveCount * 2U);
+    const auto tmpPath = path + ".tmp";
+
+    const int newFd =
+        ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (newFd < 0)
+    {
+        log<level::ERR>("Failure to create the sessions journal",
+                        entry("PATH=%s", tmpPath.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+        return false;
+    }
+    void* newMapping = MAP_FAILED;
+    if (::ftruncate(newFd, static_cast<off_t>(fileSize(newCapacity))) == 0)
+    {
+        newMapping = ::mmap(nullptr, fileSize(newCapacity),
+                            PROT_READ | PROT_WRITE, MAP_SHARED, newFd, 0);
+    }
+    if (newMapping == MAP_FAILED)
+    {
+        log<level::ERR>("Failure to map the sessions journal",
+                        entry("PATH=%s", tmpPath.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+        ::close(newFd);
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+
+    auto newRecords = reinterpret_cast<Record*>(
+        static_cast<uint8_t*>(newMapping) + sizeof(Header));
+    std::unordered_map<SessionIdentifier, uint32_t> newSlots;
+    newSlots.reserve(liveSlots.size());
+    uint32_t newTail = 0U;
+    for (const auto& [id, slot] : liveSlots)
+    {
+        newRecords[newTail] = records()[slot];
+        newSlots.emplace(id, newTail++);
+    }
+
+    // The header is written last, so the journal is valid only when all live
+    // records have been copied.
+    auto header = static_cast<Header*>(newMapping);
+    header->version = journalVersion;
+    header->capacity = newCapacity;
+    std::atomic_ref<uint32_t>(header->magic)
+        .store(journalMagic, std::memory_order_release);
+
+    if (::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        log<level::ERR>("Failure to replace the sessions journal",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+        ::munmap(newMapping, fileSize(newCapacity));
+        ::close(newFd);
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+
+    unmap();
+    liveSlots = std::move(newSlots);
+    fd = newFd;
+    mapping = newMapping;
+    capacity = newCapacity;
+    tail = newTail;
+    return true;
+}
+
+std::size_t SessionJournal::fileSize(uint32_t capacity)
+{
+    return sizeof(Header) + sizeof(Record) * capacity;
+}
+
+bool SessionJournal::map(int journalFd, uint32_t journalCapacity)
+{
+    void* journalMapping =
+        ::mmap(nullptr, fileSize(journalCapacity), PROT_READ | PROT_WRITE,
+               MAP_SHARED, journalFd, 0);
+    if (journalMapping == MAP_FAILED)
+    {
+        return false;
+    }
+    unmap();
+    fd = journalFd;
+    mapping = journalMapping;
+    capacity = journalCapacity;
+    tail = 0U;
+    return true;
+}
+
+void SessionJournal::unmap()
+{
+    if (mapping != nullptr)
+    {
+        ::munmap(mapping, fileSize(capacity));
+        mapping = nullptr;
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    capacity = 0U;
+    tail = 0U;
+}
+
+SessionJournal::Record* SessionJournal::records() const
+{
+    return reinterpret_cast<Record*>(static_cast<uint8_t*>(mapping) +
+                                     sizeof(Header));
+}
+
+SessionJournal::Record* SessionJournal::nextRecord()
+{
+    if (mapping == nullptr)
+    {
+        return nullptr;
+    }
+    if (tail == capacity && !compact())
+    {
+        // The journal is full and can't be compacted.
+        return nullptr;
+    }
+    if (tail >= capacity * 3U / 4U)
+    {
+        scheduleCompaction();
+    }
+    return &records()[tail++];
+}
+
+void SessionJournal::commit(Record& record, RecordState state)
+{
+    std::atomic_ref<uint32_t>(record.state)
+        .store(state, std::memory_order_release);
+}
+
+void SessionJournal::scheduleCompaction()
+{
+    if (compactionScheduled)
+    {
+        return;
+    }
+    compactionScheduled = true;
+    compactionTimer.expires_from_now(1s);
+    compactionTimer.async_wait([this](const boost::system::error_code& ec) {
+        if (ec != boost::asio::error::operation_aborted && mapping != nullptr)
+        {
+            compact();
+        }
+    });
+}
+
+} // namespace session
+} // namespace obmc
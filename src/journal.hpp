@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <boost/asio.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace obmc
+{
+namespace session
+{
+
+using SessionIdentifier = std::size_t;
+
+/**
+ * @brief Memory-mapped append-only journal of the session table.
+ *
+ * Each session creation and removal appends a fixed-size record to the
+ * memory-mapped file. A record is written with plain memory stores and
+ * committed by its state field stored last, so a crash of the service never
+ * leaves a torn record visible. The records of closed sessions are dropped by
+ * the compaction, which rewrites the live records into a new file and
+ * atomically replaces the journal. The compaction is scheduled on the event
+ * loop and never runs within the request handling unless the journal is full.
+ */
+class SessionJournal
+{
+  public:
+    /** @brief A session restored from the journal */
+    struct Entry
+    {
+        SessionIdentifier id;
+        pid_t ownerPid;
+        uint8_t type;
+        std::string userName;
+        std::string remoteAddress;
+    };
+
+    SessionJournal() = delete;
+    SessionJournal(const SessionJournal&) = delete;
+    SessionJournal& operator=(const SessionJournal&) = delete;
+    SessionJournal(SessionJournal&&) = delete;
+    SessionJournal& operator=(SessionJournal&&) = delete;
+
+    /** @brief Constructs the sessions journal
+     *
+     * @param[in] ioc       - ASIO context to schedule the compaction
+     * @param[in] path      - the path of the journal file
+     */
+    SessionJournal(boost::asio::io_context& ioc, std::string path);
+    ~SessionJournal();
+
+    /**
+     * @brief Open the journal and read the sessions recorded by the previous
+     *        instance of the service. The journal is disabled if the file
+     *        can't be mapped.
+     *
+     * @return the list of live sessions recorded in the journal.
+     */
+    std::vector<Entry> load();
+
+    /**
+     * @brief Record the created session. The session with the user name
+     *        longer than 32 characters or the remote address longer than 64
+     *        ones is logged and not recorded.
+     *
+     * @return false if the session can't be recorded.
+     */
+    bool append(SessionIdentifier id, const std::string& userName,
+                const std::string& remoteAddress, uint8_t type,
+                pid_t ownerPid);
+
+    /**
+     * @brief Record the removal of the session.
+     */
+    void remove(SessionIdentifier id);
+
+    /**
+     * @brief Rewrite the live records into a new journal file.
+     *
+     * @return false if the compaction has failed.
+     */
+    bool compact();
+
+  private:
+    static constexpr uint32_t journalMagic = 0x534d4a4c; // SMJL
+    static constexpr uint32_t journalVersion = 1U;
+    static constexpr uint32_t minCapacity = 1024U;
+    static constexpr std::size_t maxUserNameLength = 32U;
+    static constexpr std::size_t maxRemoteAddressLength = 64U;
+
+    enum RecordState : uint32_t
+    {
+        empty = 0U,
+        added = 1U,
+        removed = 2U,
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t reserved;
+    };
+
+    struct Record
+    {
+        uint32_t state;
+        int32_t ownerPid;
+        uint64_t id;
+        uint8_t type;
+        uint8_t userNameLength;
+        uint8_t remoteAddressLength;
+        uint8_t reserved[5];
+        char userName[maxUserNameLength];
+        char remoteAddress[maxRemoteAddressLength];
+        uint8_t padding[8];
+    };
+    static_assert(sizeof(Header) == 16U);
+    static_assert(sizeof(Record) == 128U);
+
+    static std::size_t fileSize(uint32_t capacity);
+
+    bool map(int fd, uint32_t capacity);
+    void unmap();
+    Record* records() const;
+    Record* nextRecord();
+    void commit(Record& record, RecordState state);
+    void scheduleCompaction();
+
+    boost::asio::io_context& ioc;
+    boost::asio::steady_timer compactionTimer;
+    const std::string path;
+    int fd;
+    void* mapping;
+    uint32_t capacity;
+    uint32_t tail;
+    bool compactionScheduled;
+    /** @brief Slot of the `added` record of each live session */
+    std::unordered_map<SessionIdentifier, uint32_t> liveSlots;
+};
+
+} // namespace session
+} // namespace obmc
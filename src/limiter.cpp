@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <limiter.hpp>
+
+#include <algorithm>
+
+namespace obmc
+{
+namespace session
+{
+
+namespace
+{
+constexpr std::size_t minPruneThreshold = 1024U;
+} // namespace
+
+bool TokenBucket::refill(const RateLimit& limit, Clock::time_point now)
+{
+    if (tokens < 0.0)
+    {
+        // A new bucket starts full.
+        tokens = limit.burst;
+    }
+    else
+    {
+        const std::chrono::duration<double> elapsed = now - updated;
+        tokens = std::min(limit.burst, tokens + elapsed.count() * limit.rate);
+    }
+    updated = now;
+    return tokens >= 1.0;
+}
+
+void TokenBucket::consume()
+{
+    tokens -= 1.0;
+}
+
+bool TokenBucket::isFull(const RateLimit& limit, Clock::time_point now) const
+{
+    const std::chrono::duration<double> elapsed = now - updated;
+    return tokens + elapsed.count() * limit.rate >= limit.burst;
+}
+
+CreateLimiter::CreateLimiter(const Config& config, const SessionIndex& index) :
+    config(config), index(index), userPruneThreshold(minPruneThreshold),
+    addressPruneThreshold(minPruneThreshold), quotaRejections(0U),
+    rateRejections(0U)
+{}
+
+CreateLimiter::Verdict CreateLimiter::check(const std::string& userName,
+                                            const std::string& remoteAddress,
+                                            SessionType type)
+{
+    const auto& limits = config.getLimits();
+    const auto& typeConfig = config.forType(type);
+
+    if ((limits.maxSessionsPerUser != 0U &&
+         index.byUser(userName).size() >= limits.maxSessionsPerUser) ||
+        (limits.maxSessionsPerAddress != 0U &&
+         index.byRemoteAddress(remoteAddress).size() >=
+             limits.maxSessionsPerAddress) ||
+        (typeConfig.maxSessions != 0U &&
+         index.byType(type).size() >= typeConfig.maxSessions))
+    {
+        ++quotaRejections;
+        return Verdict::quotaExceeded;
+    }
+
+    const auto now = Clock::now();
+    TokenBucket* userBucket = nullptr;
+    TokenBucket* addressBucket = nullptr;
+    TokenBucket* typeBucket = nullptr;
+    bool allowed = true;
+    if (limits.createRatePerUser.rate > 0.0)
+    {
+        prune(userBuckets, userPruneThreshold, limits.createRatePerUser, now);
+        userBucket = &userBuckets[userName];
+        allowed &= userBucket->refill(limits.createRatePerUser, now);
+    }
+    if (limits.createRatePerAddress.rate > 0.0)
+    {
+        prune(addressBuckets, addressPruneThreshold,
+              limits.createRatePerAddress, now);
+        // All spellings of the address share the bucket.
+        addressBucket = &addressBuckets[normalizeAddress(remoteAddress)];
+        allowed &= addressBucket->refill(limits.createRatePerAddress, now);
+    }
+    if (typeConfig.createRate.rate > 0.0)
+    {
+        typeBucket = &typeBuckets[type];
+        allowed &= typeBucket->refill(typeConfig.createRate, now);
+    }
+    if (!allowed)
+    {
+        ++rateRejections;
+        return Verdict::rateLimited;
+    }
+
+    // The tokens are taken only if all buckets allow the request.
+    for (auto bucket : {userBucket, addressBucket, typeBucket})
+    {
+        if (bucket != nullptr)
+        {
+            bucket->consume();
+        }
+    }
+    return Verdict::allowed;
+}
+
+uint64_t CreateLimiter::getQuotaRejections() const
+{
+    return quotaRejections;
+}
+
+uint64_t CreateLimiter::getRateRejections() const
+{
+    return rateRejections;
+}
+
+template <typename Key>
+void CreateLimiter::prune(Buckets<Key>& buckets, std::size_t& threshold,
+                          const RateLimit& limit, Clock::time_point now)
+{
+    if (buckets.size() < threshold)
+    {
+        return;
+    }
+
+    // The buckets refilled up to the burst are equal to new ones, so they
+    // are dropped. The threshold doubles with the remaining buckets count to
+    // keep the amortized cost of the check constant.
+    std::erase_if(buckets, [&limit, now](const auto& item) {
+        return item.second.isFull(limit, now);
+    });
+    threshold = std::max(minPruneThreshold, buckets.size() * 2U);
+}
+
+} // namespace session
+} // namespace obmc
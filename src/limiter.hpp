@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <config.hpp>
+#include <session_index.hpp>
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+namespace obmc
+{
+namespace session
+{
+
+/**
+ * @brief Token bucket of the session creation rate limit.
+ */
+class TokenBucket
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Refill the bucket according to the elapsed time.
+     *
+     * @return true if the bucket holds a token.
+     */
+    bool refill(const RateLimit& limit, Clock::time_point now);
+
+    /** @brief Take a token from the bucket. */
+    void consume();
+
+    /** @brief Check whether the bucket would be refilled up to the burst. */
+    bool isFull(const RateLimit& limit, Clock::time_point now) const;
+
+  private:
+    double tokens = -1.0;
+    Clock::time_point updated;
+};
+
+/**
+ * @brief Applies the concurrent sessions quotas and the creation rate limits
+ *        to each new session request.
+ *
+ * The quotas are checked against the session index sizes and the rate limits
+ * are token buckets per user, per remote address and per session type, so a
+ * check costs O(1). Buckets refilled up to the burst are dropped from time to
+ * time to keep the memory bounded under requests from random addresses.
+ */
+class CreateLimiter
+{
+  public:
+    using Clock = TokenBucket::Clock;
+    using SessionType = Config::SessionType;
+
+    enum class Verdict
+    {
+        allowed,
+        quotaExceeded,
+        rateLimited,
+    };
+
+    CreateLimiter() = delete;
+    CreateLimiter(const CreateLimiter&) = delete;
+    CreateLimiter& operator=(const CreateLimiter&) = delete;
+    CreateLimiter(CreateLimiter&&) = delete;
+    CreateLimiter& operator=(CreateLimiter&&) = delete;
+    ~CreateLimiter() = default;
+
+    /** @brief Constructs the limiter
+     *
+     * @param[in] config    - the session manager configuration
+     * @param[in] index     - the index of existing sessions
+     */
+    CreateLimiter(const Config& config, const SessionIndex& index);
+
+    /**
+     * @brief Check the session creation request and take the rate limit
+     *        tokens if the request is allowed.
+     *
+     * @return Verdict  - `allowed` if the session might be created.
+     */
+    Verdict check(const std::string& userName,
+                  const std::string& remoteAddress, SessionType type);
+
+    /** @brief Get count of requests rejected by quotas. */
+    uint64_t getQuotaRejections() const;
+
+    /** @brief Get count of requests rejected by rate limits. */
+    uint64_t getRateRejections() const;
+
+  private:
+    template <typename Key>
+    using Buckets = std::unordered_map<Key, TokenBucket>;
+
+    template <typename Key>
+    static void prune(Buckets<Key>& buckets, std::size_t& threshold,
+                      const RateLimit& limit, Clock::time_point now);
+
+    const Config& config;
+    const SessionIndex& index;
+    Buckets<std::string> userBuckets;
+    Buckets<std::string> addressBuckets;
+    Buckets<SessionType> typeBuckets;
+    std::size_t userPruneThreshold;
+    std::size_t addressPruneThreshold;
+    uint64_t quotaRejections;
+    uint64_t rateRejections;
+};
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <systemd/sd-daemon.h>
+
+#include <loop_monitor.hpp>
+#include <phosphor-logging/log.hpp>
+
+namespace obmc
+{
+namespace session
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+unsigned long long toMicroseconds(LoopMonitor::Clock::duration duration)
+{
+    return static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration)
+            .count());
+}
+} // namespace
+
+LoopMonitor::Handler::Handler(LoopMonitor& monitor, const char* name) :
+    monitor(monitor), name(name), start(), outermost(false)
+{
+    if (monitor.handlerDepth++ == 0U)
+    {
+        outermost = true;
+        start = Clock::now();
+    }
+}
+
+LoopMonitor::Handler::~Handler()
+{
+    --monitor.handlerDepth;
+    if (!outermost)
+    {
+        return;
+    }
+    const auto duration = Clock::now() - start;
+    if (duration >= monitor.threshold)
+    {
+        ++monitor.slowHandlers;
+        log<level::WARNING>("Slow event loop handler",
+                            entry("HANDLER=%s", name),
+                            entry("DURATION_US=%llu",
+                                  toMicroseconds(duration)));
+    }
+}
+
+LoopMonitor::LoopMonitor(boost::asio::io_context& ioc, LatencyHistogram& lag,
+                         uint64_t& slowHandlers,
+                         std::chrono::milliseconds threshold) :
+    timer(ioc),
+    lag(lag), slowHandlers(slowHandlers), threshold(threshold),
+    watchdogInterval(Clock::duration::zero()), handlerDepth(0U)
+{}
+
+void LoopMonitor::start()
+{
+    uint64_t watchdogUsec = 0U;
+    if (sd_watchdog_enabled(0, &watchdogUsec) > 0 && watchdogUsec != 0U)
+    {
+        // Ping twice per the watchdog timeout, as systemd recommends.
+        watchdogInterval = std::chrono::microseconds(watchdogUsec / 2U);
+        log<level::INFO>("The watchdog is enabled",
+                         entry("TIMEOUT_US=%llu",
+                               static_cast<unsigned long long>(watchdogUsec)));
+    }
+    lastPing = Clock::now();
+    schedule();
+}
+
+void LoopMonitor::schedule()
+{
+    expected = Clock::now() + probeInterval;
+    timer.expires_at(expected);
+    timer.async_wait(
+        std::bind(&LoopMonitor::probe, this, std::placeholders::_1));
+}
+
+void LoopMonitor::probe(const boost::system::error_code& ec)
+{
+    if (ec == boost::asio::error::operation_aborted)
+    {
+        return;
+    }
+
+    const auto now = Clock::now();
+    const auto late = now - expected;
+    lag.record(late);
+    if (late >= threshold)
+    {
+        log<level::WARNING>("The event loop is lagging",
+                            entry("LAG_US=%llu", toMicroseconds(late)));
+    }
+
+    // The pings come from the loop itself, so the watchdog fires if the loop
+    // stalls for the watchdog timeout.
+    if (watchdogInterval != Clock::duration::zero() &&
+        now - lastPing >= watchdogInterval - probeInterval)
+    {
+        sd_notify(0, "WATCHDOG=1");
+        lastPing = now;
+    }
+    schedule();
+}
+
+} // namespace session
+} // namespace obmc
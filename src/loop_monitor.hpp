@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <stats.hpp>
+
+#include <chrono>
+#include <cstdint>
+
+namespace obmc
+{
+namespace session
+{
+
+/**
+ * @brief Watches the responsiveness of the event loop.
+ *
+ * A periodic timer measures how late the loop runs its handlers, records the
+ * lag into the histogram and feeds the systemd watchdog, so a stalled loop
+ * misses the pings and the service is restarted. The handlers which may take
+ * long are measured by `Handler` scopes, and both the lag and the handlers
+ * exceeding the threshold are logged.
+ */
+class LoopMonitor
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /** @brief The interval of the lag probes */
+    static constexpr auto probeInterval = std::chrono::milliseconds(100);
+
+    /**
+     * @brief Measures the event loop handler. The nested scopes are
+     *        accounted to the outermost one.
+     */
+    class Handler
+    {
+      public:
+        Handler() = delete;
+        Handler(const Handler&) = delete;
+        Handler& operator=(const Handler&) = delete;
+        Handler(Handler&&) = delete;
+        Handler& operator=(Handler&&) = delete;
+
+        /** @brief Starts measuring the handler.
+         *
+         * @param[in] monitor   - the loop monitor
+         * @param[in] name      - the handler name to log, a string literal
+         */
+        Handler(LoopMonitor& monitor, const char* name);
+        ~Handler();
+
+      private:
+        LoopMonitor& monitor;
+        const char* name;
+        Clock::time_point start;
+        bool outermost;
+    };
+
+    LoopMonitor() = delete;
+    LoopMonitor(const LoopMonitor&) = delete;
+    LoopMonitor& operator=(const LoopMonitor&) = delete;
+    LoopMonitor(LoopMonitor&&) = delete;
+    LoopMonitor& operator=(LoopMonitor&&) = delete;
+    ~LoopMonitor() = default;
+
+    /** @brief Constructs the loop monitor
+     *
+     * @param[in] ioc           - ASIO context
+     * @param[in] lag           - the histogram of the loop lag
+     * @param[in] slowHandlers  - the counter of the slow handlers
+     * @param[in] threshold     - the lag or the handler duration to log
+     */
+    LoopMonitor(boost::asio::io_context& ioc, LatencyHistogram& lag,
+                uint64_t& slowHandlers, std::chrono::milliseconds threshold);
+
+    /** @brief Start probing the loop and pinging the watchdog if the service
+     *         manager has enabled it.
+     */
+    void start();
+
+  private:
+    void schedule();
+    void probe(const boost::system::error_code& ec);
+
+    boost::asio::steady_timer timer;
+    LatencyHistogram& lag;
+    uint64_t& slowHandlers;
+    Clock::duration threshold;
+    /** @brief The interval of the watchdog pings, zero if disabled */
+    Clock::duration watchdogInterval;
+    Clock::time_point lastPing;
+    Clock::time_point expected;
+    unsigned int handlerDepth;
+};
+
+} // namespace session
+} // namespace obmc
@@ -1,24 +1,60 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright (C) 2021 YADRO
 
+#include <getopt.h>
+#include <systemd/sd-daemon.h>
+
 #include <boost/asio.hpp>
 #include <manager.hpp>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/asio/connection.hpp>
+#include <sdbusplus/asio/object_server.hpp>
 
 #include <iostream>
+#include <string>
 
 using namespace phosphor::logging;
 using namespace sdbusplus::asio;
 
-int main()
+int main(int argc, char* argv[])
 {
+    // The paths are overridden by test setups only, which run the service
+    // next to the instance of the system.
+    std::string journalPath =
+        obmc::session::SessionManager::defaultJournalPath;
+    std::string auditPath = obmc::session::AuditLog::defaultPath;
+    std::string tablePath = obmc::session::table::defaultPath;
+    int opt;
+    while ((opt = ::getopt(argc, argv, "j:a:t:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'j':
+                journalPath = optarg;
+                break;
+            case 'a':
+                auditPath = optarg;
+                break;
+            case 't':
+                tablePath = optarg;
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0]
+                          << " [-j JOURNAL] [-a AUDIT] [-t TABLE]\n";
+                return EXIT_FAILURE;
+        }
+    }
+
     boost::asio::io_context io;
 
-    sdbusplus::asio::connection systemConn(io);
-    auto sessionManager =
-        std::make_shared<obmc::session::SessionManager>(systemConn, io);
+    auto systemConn = std::make_shared<sdbusplus::asio::connection>(io);
+    sdbusplus::asio::object_server server(systemConn, true);
+    auto sessionManager = std::make_shared<obmc::session::SessionManager>(
+        *systemConn, io, server, journalPath, auditPath, tablePath);
+    // The name is owned and all objects are registered by now, so the
+    // dependent services may start.
+    sd_notify(0, "READY=1");
 
     log<level::DEBUG>("io.run()");
     io.run();
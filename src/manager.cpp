@@ -5,13 +5,17 @@
 #include <manager.hpp>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
+#include <probes.hpp>
 #include <session.hpp>
 #include <xyz/openbmc_project/Session/Item/client.hpp>
 #include <xyz/openbmc_project/Session/Manager/client.hpp>
 
+#include <signal.h>
+
+#include <cerrno>
+#include <charconv>
 #include <chrono>
-#include <filesystem>
-#include <sstream>
+#include <cstring>
 
 namespace obmc
 {
@@ -22,108 +26,667 @@ using namespace obmc::dbus;
 using namespace phosphor::logging;
 using namespace std::chrono_literals;
 
-namespace fs = std::filesystem;
-
 SessionManager::SessionManager(sdbusplus::bus::bus& busIn,
-                               boost::asio::io_context& ioc) :
+                               boost::asio::io_context& ioc,
+                               sdbusplus::asio::object_server& server,
+                               const std::string& journalPath,
+                               const std::string& auditPath,
+                               const std::string& tablePath) :
     SessionManagerServer(busIn, sessionManagerObjectPath),
-    bus(busIn), ioc(ioc), timer(ioc)
+    bus(busIn), ioc(ioc), config(Config::load(Config::defaultPath)),
+    users(busIn, ioc, config.getService().allowUnknownUsers,
+          std::bind(&SessionManager::revokeUserSessions, this,
+                    std::placeholders::_1),
+          std::bind(&SessionManager::revokeDisallowedSessions, this)),
+    ownerWatcher(ioc,
+                 std::bind(&SessionManager::reapOwner, this,
+                           std::placeholders::_1),
+                 std::bind(&SessionManager::scheduleOwnerCheck, this)),
+    removalReason(nullptr), removalBatchDepth(0U), teardownTimer(ioc),
+    teardownScheduled(false), timer(ioc), ownerCheckScheduled(false),
+    journal(ioc, journalPath), audit(auditPath),
+    sharedTable(tablePath, config.getService().sessionTableCapacity),
+    timeouts(ioc, config,
+             std::bind(&SessionManager::expireSession, this,
+                       std::placeholders::_1)),
+    limiter(config, sessionIndex),
+    stats(busIn, sessionStatsObjectPath, sessionIndex, limiter),
+    changes(ioc, std::bind(&SessionManager::emitSessionsChanged, this,
+                           std::placeholders::_1, std::placeholders::_2,
+                           std::placeholders::_3)),
+    activity(ioc, config.getService().activityInterval, sessions,
+             std::bind(&SessionManager::publishActivity, this,
+                       std::placeholders::_1)),
+    loopMonitor(ioc, stats.loopLag, stats.counters.slowHandlers,
+                config.getService().slowHandlerThreshold)
 {
     dbusManager = std::make_unique<sdbusplus::server::manager::manager>(
         bus, sessionManagerObjectPath);
+    // A single rule for the released names, the unique ones are released
+    // when the connection drops.
+    connectionWatch = std::make_unique<sdbusplus::bus::match::match>(
+        bus,
+        sdbusplus::bus::match::rules::nameOwnerChanged() +
+            sdbusplus::bus::match::rules::argN(2, ""),
+        std::bind(&SessionManager::onNameOwnerChanged, this,
+                  std::placeholders::_1));
+
+    managerIface = server.add_interface(sessionManagerObjectPath,
+                                        session_manager::interface);
+    managerIface->register_method(
+        "CloseByUser", [this](const std::string& userName) {
+            return static_cast<uint32_t>(this->removeAll(userName));
+        });
+    managerIface->register_method(
+        "CloseByRemoteAddress", [this](const std::string& remoteAddress) {
+            return static_cast<uint32_t>(
+                this->removeAllByRemoteAddress(remoteAddress));
+        });
+    managerIface->register_method(
+        "CloseByNetwork", [this](const std::string& network) {
+            return static_cast<uint32_t>(this->removeAllByNetwork(network));
+        });
+    managerIface->register_method(
+        "CountByNetwork", [this](const std::string& network) {
+            return static_cast<uint32_t>(this->countByNetwork(network));
+        });
+    managerIface->register_method(
+        "CreateMany", [this](const std::vector<CreateRequest>& requests) {
+            return this->createMany(requests);
+        });
+    managerIface->register_method(
+        "CloseMany", [this](const std::vector<std::string>& sessionIds) {
+            return this->closeMany(sessionIds);
+        });
+    managerIface->register_method(
+        "GetSession", [this](const std::string& sessionId) {
+            return this->getSessionDetails(sessionId);
+        });
+    managerIface->register_method(
+        "GetSessionsByUser", [this](const std::string& userName) {
+            return this->getSessionsByUser(userName);
+        });
+    managerIface->register_method(
+        "GetSessionsByRemoteAddress",
+        [this](const std::string& remoteAddress) {
+            return this->getSessionsByRemoteAddress(remoteAddress);
+        });
+    managerIface->register_method(
+        "GetSessionsByType", [this](const std::string& type) {
+            return this->getSessionsByType(
+                SessionItemServer::convertTypeFromString(type));
+        });
+    managerIface->register_method(
+        "Touch", [this](const std::vector<std::string>& sessionIds) {
+            this->touch(sessionIds);
+        });
+    managerIface->register_method("GetChangesSince", [this](uint64_t since) {
+        return this->getChangesSince(since);
+    });
+    managerIface->register_signal<uint64_t, std::vector<std::string>,
+                                  std::vector<std::string>>(
+        "SessionsChanged");
+    managerIface->register_signal<std::string, uint32_t>("SessionsClosed");
+    managerIface->initialize();
+
+    if (config.getService().virtualObjects)
+    {
+        virtualObjects = std::make_unique<VirtualSessionObjects>(
+            bus, sessionManagerObjectPath, sessions);
+    }
+
+    // Bring back the sessions of the previous service instance before the
+    // service name is acquired, so clients never see them missing.
+    restoreSessions();
+    sharedTable.publish();
+
     bus.request_name(serviceName);
-    timer.expires_from_now(10s);
-    timer.async_wait(std::bind(&SessionManager::checkSessionOwnerAlive, this,
-                               std::placeholders::_1));
+    loopMonitor.start();
 }
 
+// The store owns the session objects, which are complete here only.
+SessionManager::~SessionManager() = default;
+
 std::string SessionManager::create(std::string username,
                                    std::string remoteAddress, SessionType type,
                                    int32_t callerPid)
 {
-    auto session = this->create(username, remoteAddress, callerPid);
-    if (!session)
+    LoopMonitor::Handler handlerScope(loopMonitor, "Create");
+    alloc::Scope allocScope(createAllocations);
+    LatencyHistogram::Scope latencyScope(stats.createLatency);
+    ProbeTimer probeTimer(SESSION_PROBE_ENABLED(create_return));
+
+    std::string ownerConnection;
+    callerPid = identifyCaller(callerPid, ownerConnection);
+    SESSION_PROBE(create_entry, static_cast<int>(type), callerPid);
+
+    // The limits are applied before anything is allocated for the session.
+    switch (limiter.check(username, remoteAddress, type))
     {
+        case CreateLimiter::Verdict::allowed:
+            break;
+        case CreateLimiter::Verdict::quotaExceeded:
+            audit.record(AuditLog::Event::rejected, "QuotaExceeded", 0U,
+                         username, remoteAddress, static_cast<uint8_t>(type),
+                         callerPid);
+            SESSION_PROBE(create_return, 0U, static_cast<int>(type),
+                          probeTimer.elapsed());
+            throwDbusError(SessionError::quotaExceeded);
+            break;
+        case CreateLimiter::Verdict::rateLimited:
+            audit.record(AuditLog::Event::rejected, "RateLimited", 0U,
+                         username, remoteAddress, static_cast<uint8_t>(type),
+                         callerPid);
+            SESSION_PROBE(create_return, 0U, static_cast<int>(type),
+                          probeTimer.elapsed());
+            throwDbusError(SessionError::rateLimited);
+            break;
+    }
+
+    auto record = this->createSession(username, remoteAddress, type,
+                                      callerPid, ownerConnection);
+    if (record == nullptr)
+    {
+        audit.record(AuditLog::Event::rejected, "NotAllowed", 0U, username,
+                     remoteAddress, static_cast<uint8_t>(type), callerPid);
+        ++stats.counters.rejectedNotAllowed;
+        SESSION_PROBE(create_return, 0U, static_cast<int>(type),
+                      probeTimer.elapsed());
         throw InvalidArgument();
     }
-    session->sessionType(type);
-    return session->sessionID();
+    ++stats.counters.creates;
+    SESSION_PROBE(create_return, record->id, static_cast<int>(type),
+                  probeTimer.elapsed());
+    return hexSessionId(record->id);
 }
 
-SessionItemPtr SessionManager::create(const std::string& userName,
-                                      const std::string& remoteAddress,
-                                      pid_t callerPid)
+SessionRecord* SessionManager::createSession(const std::string& userName,
+                                            const std::string& remoteAddress,
+                                            SessionType type, pid_t callerPid,
+                                            const std::string& ownerConnection)
 {
-    auto sessionId = generateSessionId();
+    if (!userName.empty() && (!SessionItem::isAllowedOwner(userName) ||
+                              !users.isAllowed(userName)))
+    {
+        return nullptr;
+    }
 
-    auto sessionObjectPath = getSessionObjectPath(sessionId);
-    auto session =
-        std::make_shared<SessionItem>(bus, sessionObjectPath, callerPid);
+    auto sessionId = generateSessionId();
+    SessionItemPtr session;
+    if (!virtualObjects)
+    {
+        session =
+            buildSession(sessionId, userName, remoteAddress, type, callerPid);
+        publishSession(sessionId, *session, type);
+    }
+    auto& record = insertSession(sessionId, std::move(session), userName,
+                                 remoteAddress, type, callerPid,
+                                 ownerConnection);
+    if (virtualObjects)
+    {
+        virtualObjects->emitAdded(sessionId);
+    }
+    journal.append(sessionId, userName, remoteAddress,
+                   static_cast<uint8_t>(type), callerPid);
+    audit.record(AuditLog::Event::created, "Create", sessionId, userName,
+                 remoteAddress, static_cast<uint8_t>(type), callerPid);
+    return &record;
+}
 
-    session->sessionID(hexSessionId(sessionId));
-    session->remoteIPAddr(remoteAddress);
+SessionItemPtr SessionManager::buildSession(SessionIdentifier sessionId,
+                                            const std::string& userName,
+                                            const std::string& remoteAddress,
+                                            SessionType type, pid_t callerPid)
+{
+    ObjectPathBuffer sessionObjectPath;
+    formatSessionObjectPath(sessionId, sessionObjectPath);
+    auto session = std::make_unique<SessionItem>(
+        bus, sessionObjectPath.data(), callerPid);
 
+    // The object is not announced yet, so the properties are set silently
+    // and published by a single signal later.
+    SessionIdBuffer hexId;
+    session->sessionID(std::string(formatSessionId(sessionId, hexId)), true);
+    session->remoteIPAddr(remoteAddress, true);
+    session->sessionType(type, true);
     if (!userName.empty())
     {
-        try
+        session->adjustSessionOwner(userName, true);
+    }
+    return session;
+}
+
+void SessionManager::publishSession(SessionIdentifier sessionId,
+                                    SessionItem& session, SessionType type)
+{
+    ProbeTimer probeTimer(SESSION_PROBE_ENABLED(object_added));
+    session.publish();
+    SESSION_PROBE(object_added, sessionId, static_cast<int>(type),
+                  probeTimer.elapsed());
+}
+
+SessionRecord& SessionManager::insertSession(SessionIdentifier sessionId,
+                                             SessionItemPtr session,
+                                             const std::string& userName,
+                                             const std::string& remoteAddress,
+                                             SessionType type,
+                                             pid_t callerPid,
+                                             const std::string& ownerConnection)
+{
+    auto& record = sessions.insert(sessionId, userName, remoteAddress, type,
+                                   callerPid, ownerConnection,
+                                   std::move(session));
+    sessionIndex.insert(sessionId, userName, remoteAddress, type, callerPid,
+                        ownerConnection);
+    changes.added(sessionId);
+    sharedTable.insert(sessionId, userName, static_cast<uint8_t>(type),
+                       callerPid);
+    record.expiry = timeouts.arm(sessionId, type);
+    record.lastActivity = ActivityTracker::now();
+    if (record.object)
+    {
+        record.object->setExpiry(record.expiry);
+        record.object->setLastActivity(record.lastActivity);
+    }
+
+    switch (ownerWatcher.watch(callerPid))
+    {
+        case OwnerWatcher::WatchResult::watching:
+            break;
+        case OwnerWatcher::WatchResult::gone:
+            // The owner has already exited. Defer the cleanup to let the
+            // caller receive the reply first.
+            boost::asio::post(ioc, [this, callerPid]() {
+                this->reapOwner(callerPid);
+            });
+            break;
+        case OwnerWatcher::WatchResult::unsupported:
+        case OwnerWatcher::WatchResult::polled:
+            scheduleOwnerCheck();
+            break;
+    }
+    return record;
+}
+
+void SessionManager::restoreSessions()
+{
+    LoopMonitor::Handler handlerScope(loopMonitor, "Restore");
+    auto entries = journal.load();
+
+    std::vector<std::pair<const SessionJournal::Entry*, SessionItemPtr>>
+        restored;
+    restored.reserve(entries.size());
+    for (const auto& saved : entries)
+    {
+        const bool ownerAlive = saved.ownerPid > 0 &&
+                                (::kill(saved.ownerPid, 0) == 0 ||
+                                 errno == EPERM);
+        if (!ownerAlive || saved.id == invalidSessionId ||
+            (!saved.userName.empty() &&
+             (!SessionItem::isAllowedOwner(saved.userName) ||
+              !users.isAllowed(saved.userName))))
         {
-            session->adjustSessionOwner(userName);
+            journal.remove(saved.id);
+            audit.record(AuditLog::Event::closed, "Restore", saved.id,
+                         saved.userName, saved.remoteAddress, saved.type,
+                         saved.ownerPid);
+            continue;
         }
-        catch (const std::exception& ex)
+        restored.emplace_back(
+            &saved, virtualObjects
+                        ? SessionItemPtr()
+                        : buildSession(saved.id, saved.userName,
+                                       saved.remoteAddress,
+                                       static_cast<SessionType>(saved.type),
+                                       saved.ownerPid));
+    }
+
+    // All restored objects are built first and published in a row.
+    for (auto& [saved, session] : restored)
+    {
+        if (session)
         {
-            log<level::DEBUG>(
-                "Skip publishing the obmcsess object if user not found",
-                entry("USER=%d", userName.c_str()),
-                entry("ERROR=%s", ex.what()));
-            return SessionItemPtr();
+            publishSession(saved->id, *session,
+                           static_cast<SessionType>(saved->type));
         }
+        // The connection of the owner is not recorded, so the restored
+        // session is observed by the owner PID only.
+        insertSession(saved->id, std::move(session), saved->userName,
+                      saved->remoteAddress,
+                      static_cast<SessionType>(saved->type), saved->ownerPid,
+                      std::string());
+        if (virtualObjects)
+        {
+            virtualObjects->emitAdded(saved->id);
+        }
+        audit.record(AuditLog::Event::created, "Restore", saved->id,
+                     saved->userName, saved->remoteAddress, saved->type,
+                     saved->ownerPid);
     }
+    journal.compact();
 
-    sessionItems.emplace(sessionId, session);
-    return session;
+    if (!entries.empty())
+    {
+        const auto dropped = entries.size() - restored.size();
+        log<level::INFO>("Restored sessions from the journal",
+                         entry("RESTORED=%zu", restored.size()),
+                         entry("DROPPED=%zu", dropped));
+    }
 }
 
 uint32_t SessionManager::closeAllByType(SessionType type)
 {
-    const auto count = std::erase_if(sessionItems, [type](const auto& item) {
-        auto const [id, session] = item;
-        return session->sessionType() == type;
-    });
-
-    return count;
+    LoopMonitor::Handler handlerScope(loopMonitor, "CloseAllByType");
+    ProbeTimer probeTimer(SESSION_PROBE_ENABLED(close_all_by_type_return));
+    SESSION_PROBE(close_all_by_type_entry, static_cast<int>(type));
+    ++stats.counters.closeAllByTypeCalls;
+    const auto count =
+        closeSessions(sessionIndex.byType(type), "CloseAllByType");
+    stats.counters.closes += count;
+    SESSION_PROBE(close_all_by_type_return, static_cast<int>(type), count,
+                  probeTimer.elapsed());
+    return static_cast<uint32_t>(count);
 }
 
 void SessionManager::close(std::string sessionId)
 {
-    log<level::DEBUG>("SessionManager::close()",
-                      entry("SESSION-ID=%d", sessionId.c_str()));
-    try
+    LoopMonitor::Handler handlerScope(loopMonitor, "Close");
+    const auto error = closeSession(sessionId);
+    if (error != SessionError::none)
     {
-        auto numSessId = parseSessionId(sessionId);
-        auto foundSessionIt = sessionItems.find(numSessId);
-        if (foundSessionIt == sessionItems.end())
-        {
+        log<level::DEBUG>("Failure to close an obmc session.",
+                          entry("SESSION-ID=%s", sessionId.c_str()),
+                          entry("ERROR=%s", errorName(error)));
+        throwDbusError(error);
+    }
+}
+
+SessionManager::SessionError
+    SessionManager::closeSession(std::string_view sessionId,
+                                 const char* cause)
+{
+    alloc::Scope allocScope(closeAllocations);
+    LatencyHistogram::Scope latencyScope(stats.closeLatency);
+    ProbeTimer probeTimer(SESSION_PROBE_ENABLED(close_return));
+    const auto numSessId = parseSessionId(sessionId);
+    SESSION_PROBE(close_entry, numSessId.value_or(0U));
+
+    auto error = SessionError::none;
+    auto record = numSessId ? sessions.find(*numSessId) : nullptr;
+    if (!numSessId)
+    {
+        error = SessionError::invalidSessionId;
+    }
+    else if (record == nullptr)
+    {
+        error = SessionError::unknownSession;
+    }
+    else
+    {
+        eraseSession(*record, cause);
+        ++stats.counters.closes;
+    }
+    SESSION_PROBE(close_return, numSessId.value_or(0U),
+                  static_cast<int>(error), probeTimer.elapsed());
+    return error;
+}
+
+const char* SessionManager::errorName(SessionError error)
+{
+    switch (error)
+    {
+        case SessionError::none:
+            return "";
+        case SessionError::invalidSessionId:
+        case SessionError::unknownSession:
+        case SessionError::notAllowedUser:
+            return InvalidArgument::errName;
+        case SessionError::quotaExceeded:
+            return dbus::session_manager::error::QuotaExceeded::errName;
+        case SessionError::rateLimited:
+            return dbus::session_manager::error::RateLimited::errName;
+    }
+    return InternalFailure::errName;
+}
+
+void SessionManager::throwDbusError(SessionError error)
+{
+    switch (error)
+    {
+        case SessionError::none:
+            return;
+        case SessionError::invalidSessionId:
+        case SessionError::unknownSession:
+        case SessionError::notAllowedUser:
             throw InvalidArgument();
+        case SessionError::quotaExceeded:
+            throw dbus::session_manager::error::QuotaExceeded();
+        case SessionError::rateLimited:
+            throw dbus::session_manager::error::RateLimited();
+    }
+    throw InternalFailure();
+}
+
+const alloc::Stats& SessionManager::getCreateAllocations() const
+{
+    return createAllocations;
+}
+
+const alloc::Stats& SessionManager::getCloseAllocations() const
+{
+    return closeAllocations;
+}
+
+const CreateLimiter& SessionManager::getLimiter() const
+{
+    return limiter;
+}
+
+std::vector<SessionManager::CreateResult>
+    SessionManager::createMany(const std::vector<CreateRequest>& requests)
+{
+    LoopMonitor::Handler handlerScope(loopMonitor, "CreateMany");
+    std::vector<CreateResult> results;
+    results.reserve(requests.size());
+    for (const auto& [userName, remoteAddress, type, callerPid] : requests)
+    {
+        try
+        {
+            results.emplace_back(
+                create(userName, remoteAddress,
+                       SessionItemServer::convertTypeFromString(type),
+                       callerPid),
+                std::string());
+        }
+        catch (const sdbusplus::exception_t& e)
+        {
+            results.emplace_back(std::string(), e.name());
         }
-        sessionItems.erase(foundSessionIt);
     }
-    catch (const std::exception& e)
+    return results;
+}
+
+std::vector<std::string>
+    SessionManager::closeMany(const std::vector<std::string>& sessionIds)
+{
+    LoopMonitor::Handler handlerScope(loopMonitor, "CloseMany");
+    RemovalBatch batch(*this, "CloseMany");
+    std::vector<std::string> results;
+    results.reserve(sessionIds.size());
+    for (const auto& sessionId : sessionIds)
+    {
+        results.emplace_back(errorName(closeSession(sessionId, "CloseMany")));
+    }
+    return results;
+}
+
+void SessionManager::touch(const std::vector<std::string>& sessionIds)
+{
+    // A single clock read stamps the whole batch.
+    const auto now = ActivityTracker::now();
+    for (const auto& sessionId : sessionIds)
+    {
+        const auto numSessId = parseSessionId(sessionId);
+        auto record = numSessId ? sessions.find(*numSessId) : nullptr;
+        if (record == nullptr)
+        {
+            continue;
+        }
+        record->expiry = timeouts.touch(record->id);
+        if (record->object)
+        {
+            record->object->setExpiry(record->expiry);
+            record->object->setLastActivity(now);
+        }
+        activity.touch(*record, now);
+    }
+}
+
+void SessionManager::publishActivity(const SessionRecord& record)
+{
+    if (record.object)
     {
-        log<level::ERR>("Failure to close an obmc session.",
-                        entry("SESSION-ID=%s", sessionId.c_str()),
+        // A failed signal must not stop the flush, the rest of the queued
+        // sessions are published anyway.
+        try
+        {
+            record.object->emitLastActivity();
+        }
+        catch (const sdbusplus::exception_t& e)
+        {
+            log<level::ERR>("Failure to emit the LastActivity change",
+                            entry("SESSION_ID=%zx", record.id),
+                            entry("ERROR=%s", e.what()));
+        }
+    }
+    else if (virtualObjects)
+    {
+        virtualObjects->emitLastActivity(record.id);
+    }
+}
+
+SessionManager::ChangesResult SessionManager::getChangesSince(uint64_t since)
+{
+    // The changes of the current loop turn are published first, so the
+    // reply is consistent with the signals the client receives afterwards.
+    changes.flush();
+
+    ChangeFeed::SessionIdentifierList added;
+    ChangeFeed::SessionIdentifierList removed;
+    const bool snapshot = !changes.changesSince(since, added, removed);
+    if (snapshot)
+    {
+        added = sessions.identifiers();
+        removed.clear();
+    }
+    return {changes.getGeneration(), snapshot, formatSessionIds(added),
+            formatSessionIds(removed)};
+}
+
+void SessionManager::emitSessionsChanged(
+    ChangeFeed::Generation generation,
+    const ChangeFeed::SessionIdentifierList& added,
+    const ChangeFeed::SessionIdentifierList& removed)
+{
+    try
+    {
+        auto signal = managerIface->new_signal("SessionsChanged");
+        signal.append(generation, formatSessionIds(added),
+                      formatSessionIds(removed));
+        signal.signal_send();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        // The changes stay in the feed, so GetChangesSince still has them.
+        log<level::ERR>("Failure to emit SessionsChanged",
+                        entry("GENERATION=%llu",
+                              static_cast<unsigned long long>(generation)),
                         entry("ERROR=%s", e.what()));
-        throw InternalFailure();
     }
 }
 
+std::vector<std::string> SessionManager::formatSessionIds(
+    const ChangeFeed::SessionIdentifierList& ids)
+{
+    std::vector<std::string> result;
+    result.reserve(ids.size());
+    SessionIdBuffer buffer;
+    for (const auto sessionId : ids)
+    {
+        result.emplace_back(formatSessionId(sessionId, buffer));
+    }
+    return result;
+}
+
+dbus::DBusSessionDetailsMap
+    SessionManager::getSessionDetails(const std::string& sessionId) const
+{
+    const auto numSessId = parseSessionId(sessionId);
+    if (!numSessId)
+    {
+        throwDbusError(SessionError::invalidSessionId);
+    }
+    const auto record = sessions.find(*numSessId);
+    if (record == nullptr)
+    {
+        throwDbusError(SessionError::unknownSession);
+    }
+    return sessionDetails(*record);
+}
+
+SessionManager::SessionDetailsDict
+    SessionManager::getSessionsByUser(const std::string& userName) const
+{
+    return collectSessionDetails(sessionIndex.byUser(userName));
+}
+
+SessionManager::SessionDetailsDict SessionManager::getSessionsByRemoteAddress(
+    const std::string& remoteAddress) const
+{
+    return collectSessionDetails(sessionIndex.byRemoteAddress(remoteAddress));
+}
+
+SessionManager::SessionDetailsDict
+    SessionManager::getSessionsByType(SessionType type) const
+{
+    return collectSessionDetails(sessionIndex.byType(type));
+}
+
+SessionManager::SessionDetailsDict
+    SessionManager::collectSessionDetails(const SessionIdentifierSet& ids) const
+{
+    SessionDetailsDict details;
+    SessionIdBuffer buffer;
+    for (const auto sessionId : ids)
+    {
+        const auto record = sessions.find(sessionId);
+        if (record != nullptr)
+        {
+            details.emplace(formatSessionId(sessionId, buffer),
+                            sessionDetails(*record));
+        }
+    }
+    return details;
+}
+
+dbus::DBusSessionDetailsMap
+    SessionManager::sessionDetails(const SessionRecord& record) const
+{
+    return {
+        {"SessionID", hexSessionId(record.id)},
+        {"Username", *record.userName},
+        {"RemoteIPAddr", SessionStore::getRemoteAddress(record)},
+        {"SessionType", convertForMessage(record.type)},
+        {"OwnerPID", static_cast<uint32_t>(record.ownerPid)},
+        {"Associations", SessionItem::getUserAssociations(*record.userName)},
+    };
+}
+
 std::size_t SessionManager::removeAll(const std::string& userName)
 {
     const auto count =
-        std::erase_if(sessionItems, [userName](const auto& item) {
-            auto const [id, session] = item;
-            return session->getOwner() == userName;
-        });
-
+        closeSessions(sessionIndex.byUser(userName), "CloseByUser");
+    stats.counters.closes += count;
     return count;
 }
 
@@ -131,19 +694,330 @@ std::size_t
     SessionManager::removeAllByRemoteAddress(const std::string& remoteAddress)
 {
     const auto count =
-        std::erase_if(sessionItems, [remoteAddress](const auto& item) {
-            auto const [id, session] = item;
-            return session->remoteIPAddr() == remoteAddress;
-        });
+        closeSessions(sessionIndex.byRemoteAddress(remoteAddress),
+                      "CloseByRemoteAddress");
+    stats.counters.closes += count;
+    return count;
+}
 
+std::size_t SessionManager::removeAllByNetwork(const std::string& network)
+{
+    const auto parsed = parseNetwork(network);
+    if (!parsed)
+    {
+        throw InvalidArgument();
+    }
+    const auto count =
+        closeSessions(sessionIndex.byNetwork(*parsed), "CloseByNetwork");
+    stats.counters.closes += count;
     return count;
 }
 
+std::size_t SessionManager::countByNetwork(const std::string& network) const
+{
+    const auto parsed = parseNetwork(network);
+    if (!parsed)
+    {
+        throw InvalidArgument();
+    }
+    return sessionIndex.countByNetwork(*parsed);
+}
+
 std::size_t SessionManager::removeAll()
 {
-    size_t handledSessions = sessionItems.size();
-    sessionItems.clear();
-    return handledSessions;
+    const auto count = closeSessions(sessions.identifiers(), "CloseAll");
+    stats.counters.closes += count;
+    return count;
+}
+
+void SessionManager::eraseSession(SessionRecord& record, const char* cause)
+{
+    const auto sessionId = record.id;
+    const auto remoteAddress = SessionStore::getRemoteAddress(record);
+    sessionIndex.erase(sessionId, *record.userName, remoteAddress, record.type,
+                       record.ownerPid,
+                       record.ownerConnection != nullptr
+                           ? *record.ownerConnection
+                           : std::string());
+    audit.record(AuditLog::Event::closed, cause, sessionId, *record.userName,
+                 remoteAddress, static_cast<uint8_t>(record.type),
+                 record.ownerPid);
+    journal.remove(sessionId);
+    sharedTable.erase(sessionId);
+    changes.removed(sessionId);
+    timeouts.cancel(sessionId);
+    ownerWatcher.unwatch(record.ownerPid);
+    auto session = sessions.erase(record);
+    if (removalBatchDepth > 0U)
+    {
+        pendingRemovals.push_back({sessionId, std::move(session)});
+    }
+    else
+    {
+        releaseSession(sessionId, std::move(session));
+    }
+}
+
+void SessionManager::releaseSession(SessionIdentifier sessionId,
+                                    SessionItemPtr session)
+{
+    ProbeTimer probeTimer(SESSION_PROBE_ENABLED(object_removed));
+    if (session)
+    {
+        // The destruction emits the InterfacesRemoved signal.
+        session.reset();
+    }
+    else if (virtualObjects)
+    {
+        try
+        {
+            virtualObjects->emitRemoved(sessionId);
+        }
+        catch (const sdbusplus::exception_t& e)
+        {
+            log<level::ERR>("Failure to announce the session removal",
+                            entry("ERROR=%s", e.what()));
+        }
+    }
+    SESSION_PROBE(object_removed, sessionId, probeTimer.elapsed());
+}
+
+SessionManager::RemovalBatch::RemovalBatch(SessionManager& manager,
+                                           const char* reason) :
+    manager(manager)
+{
+    if (manager.removalBatchDepth++ == 0U)
+    {
+        manager.removalReason = reason;
+    }
+}
+
+SessionManager::RemovalBatch::~RemovalBatch()
+{
+    if (--manager.removalBatchDepth != 0U)
+    {
+        return;
+    }
+    // The destructor must not throw, the sessions are already gone from the
+    // table, so only their objects are left to the next loop turn.
+    try
+    {
+        manager.queueTeardown();
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failure to tear down the closed sessions",
+                        entry("ERROR=%s", e.what()));
+        manager.scheduleTeardown();
+    }
+}
+
+void SessionManager::queueTeardown()
+{
+    if (pendingRemovals.empty())
+    {
+        return;
+    }
+
+    const bool immediate = teardownQueue.empty() &&
+                           pendingRemovals.size() <= teardownChunkSize;
+    teardownQueue.push_back({std::move(pendingRemovals), 0U, removalReason});
+    pendingRemovals.clear();
+    if (immediate)
+    {
+        tearDownChunk();
+    }
+    else
+    {
+        scheduleTeardown();
+    }
+}
+
+void SessionManager::tearDownChunk()
+{
+    LoopMonitor::Handler handlerScope(loopMonitor, "Teardown");
+    std::size_t budget = teardownChunkSize;
+    while (budget > 0U && !teardownQueue.empty())
+    {
+        auto& batch = teardownQueue.front();
+        while (budget > 0U && batch.released < batch.items.size())
+        {
+            auto& removal = batch.items[batch.released++];
+            releaseSession(removal.id, std::move(removal.object));
+            --budget;
+        }
+        if (batch.released == batch.items.size())
+        {
+            const auto reason = batch.reason;
+            const auto count = batch.items.size();
+            teardownQueue.pop_front();
+            emitSessionsClosed(reason, count);
+        }
+    }
+    scheduleTeardown();
+}
+
+void SessionManager::emitSessionsClosed(const char* reason,
+                                        std::size_t count)
+{
+    try
+    {
+        auto signal = managerIface->new_signal("SessionsClosed");
+        signal.append(std::string(reason), static_cast<uint32_t>(count));
+        signal.signal_send();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        // E.g. the outgoing queue is full amid the mass close.
+        log<level::ERR>("Failure to emit SessionsClosed",
+                        entry("REASON=%s", reason),
+                        entry("ERROR=%s", e.what()));
+    }
+}
+
+void SessionManager::scheduleTeardown()
+{
+    if (teardownScheduled || teardownQueue.empty())
+    {
+        return;
+    }
+    teardownScheduled = true;
+    // The zero timer lets the other handlers of the loop run between the
+    // chunks.
+    teardownTimer.expires_from_now(0s);
+    teardownTimer.async_wait([this](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        teardownScheduled = false;
+        tearDownChunk();
+    });
+}
+
+std::size_t SessionManager::closeSessions(const SessionIdentifierSet& ids,
+                                          const char* reason)
+{
+    // Erasing a session modifies the index set the identifiers are taken
+    // from, so work on a copy.
+    const std::vector<SessionIdentifier> matched(ids.begin(), ids.end());
+    return closeSessions(matched, reason);
+}
+
+std::size_t
+    SessionManager::closeSessions(const std::vector<SessionIdentifier>& ids,
+                                  const char* reason)
+{
+    LoopMonitor::Handler handlerScope(loopMonitor, reason);
+    RemovalBatch batch(*this, reason);
+    std::size_t count = 0U;
+    for (const auto sessionId : ids)
+    {
+        auto record = sessions.find(sessionId);
+        if (record != nullptr)
+        {
+            eraseSession(*record, reason);
+            ++count;
+        }
+    }
+    return count;
+}
+
+void SessionManager::expireSession(SessionIdentifier sessionId)
+{
+    auto record = sessions.find(sessionId);
+    if (record == nullptr)
+    {
+        return;
+    }
+    eraseSession(*record, "Expired");
+    ++stats.counters.expired;
+}
+
+std::size_t SessionManager::revokeUserSessions(const std::string& userName)
+{
+    const auto count =
+        closeSessions(sessionIndex.byUser(userName), "UserRevoked");
+    if (count != 0U)
+    {
+        log<level::INFO>("Closed sessions of the changed user",
+                         entry("USER=%s", userName.c_str()),
+                         entry("SESSIONS=%zu", count));
+    }
+    stats.counters.revokedOnUserChange += count;
+    return count;
+}
+
+std::size_t SessionManager::revokeDisallowedSessions()
+{
+    std::size_t count = 0U;
+    for (const auto& userName : sessionIndex.userNames())
+    {
+        // The sessions with no owner user are allowed by createSession().
+        if (!userName.empty() && !users.isAllowed(userName))
+        {
+            count += revokeUserSessions(userName);
+        }
+    }
+    return count;
+}
+
+std::size_t SessionManager::reapOwner(pid_t pid)
+{
+    const auto count =
+        closeSessions(sessionIndex.byOwnerPid(pid), "OwnerExited");
+    stats.counters.reapedOnOwnerExit += count;
+    return count;
+}
+
+pid_t SessionManager::identifyCaller(pid_t callerPid,
+                                     std::string& ownerConnection)
+{
+    auto message = sd_bus_get_current_message(bus.get());
+    const char* sender =
+        message != nullptr ? sd_bus_message_get_sender(message) : nullptr;
+    if (sender == nullptr)
+    {
+        // Called by the service itself.
+        return callerPid;
+    }
+    ownerConnection = sender;
+
+    // Querying the credentials costs a call to the bus daemon, so it is made
+    // once per connection.
+    auto known = connectionPids.find(ownerConnection);
+    if (known != connectionPids.end())
+    {
+        return known->second;
+    }
+    sd_bus_creds* creds = nullptr;
+    pid_t pid = 0;
+    if (sd_bus_query_sender_creds(message, SD_BUS_CREDS_PID, &creds) < 0 ||
+        sd_bus_creds_get_pid(creds, &pid) < 0 || pid <= 0)
+    {
+        sd_bus_creds_unref(creds);
+        return callerPid;
+    }
+    sd_bus_creds_unref(creds);
+    connectionPids.emplace(ownerConnection, pid);
+    return pid;
+}
+
+void SessionManager::onNameOwnerChanged(sdbusplus::message::message& message)
+{
+    std::string name;
+    std::string oldOwner;
+    std::string newOwner;
+    message.read(name, oldOwner, newOwner);
+    // The unique names start with a colon and are never reused.
+    if (!newOwner.empty() || name.empty() || name.front() != ':')
+    {
+        return;
+    }
+    connectionPids.erase(name);
+    const auto count = closeSessions(sessionIndex.byOwnerConnection(name),
+                                     "OwnerDisconnected");
+    stats.counters.reapedOnDisconnect += count;
 }
 
 SessionIdentifier SessionManager::generateSessionId() const
@@ -154,7 +1028,7 @@ SessionIdentifier SessionManager::generateSessionId() const
     std::size_t serviceNameHash = std::hash<std::string>{}(serviceName);
 
     std::size_t result = timeHash ^ (serviceNameHash << 1);
-    if (result == invalidSessionId)
+    if (result == invalidSessionId || sessions.contains(result))
     {
         // The hash-collision guard. The Session ID == invalidSessionId is
         // reserved and can't be provided as a valid ID.
@@ -167,7 +1041,8 @@ SessionIdentifier SessionManager::generateSessionId() const
 const std::string
     SessionManager::getSessionObjectPath(SessionIdentifier sessionId) const
 {
-    return getSessionManagerObjectPath() + "/" + hexSessionId(sessionId);
+    ObjectPathBuffer buffer;
+    return std::string(formatSessionObjectPath(sessionId, buffer));
 }
 
 const std::string SessionManager::getSessionManagerObjectPath() const
@@ -177,37 +1052,112 @@ const std::string SessionManager::getSessionManagerObjectPath() const
 
 const std::string SessionManager::hexSessionId(SessionIdentifier sessionId)
 {
-    std::stringstream stream;
-    stream << std::setfill('0') << std::setw(sizeof(sessionId) * 2) << std::hex
-           << sessionId;
-    return stream.str();
+    SessionIdBuffer buffer;
+    return std::string(formatSessionId(sessionId, buffer));
 }
 
-SessionIdentifier
-    SessionManager::parseSessionId(const std::string& hexSessionId)
+std::string_view SessionManager::formatSessionId(SessionIdentifier sessionId,
+                                                 SessionIdBuffer& buffer)
 {
-    return std::stoull(hexSessionId, nullptr, 16);
+    constexpr const char* hexDigits = "0123456789abcdef";
+    for (auto pos = sessionIdLength; pos > 0U; --pos)
+    {
+        buffer[pos - 1U] = hexDigits[sessionId & 0xfU];
+        sessionId >>= 4U;
+    }
+    buffer[sessionIdLength] = '\0';
+    return std::string_view(buffer.data(), sessionIdLength);
+}
+
+std::string_view
+    SessionManager::formatSessionObjectPath(SessionIdentifier sessionId,
+                                            ObjectPathBuffer& buffer)
+{
+    constexpr auto prefixLength =
+        std::char_traits<char>::length(sessionManagerObjectPath);
+    std::memcpy(buffer.data(), sessionManagerObjectPath, prefixLength);
+    buffer[prefixLength] = '/';
+
+    SessionIdBuffer hexId;
+    formatSessionId(sessionId, hexId);
+    std::memcpy(buffer.data() + prefixLength + 1U, hexId.data(),
+                hexId.size());
+    return std::string_view(buffer.data(), buffer.size() - 1U);
 }
 
-void SessionManager::checkSessionOwnerAlive(const boost::system::error_code&)
+std::optional<SessionIdentifier>
+    SessionManager::parseSessionId(std::string_view hexSessionId)
 {
-    for (auto it = sessionItems.begin(); it != sessionItems.end();)
+    SessionIdentifier sessionId = invalidSessionId;
+    const auto end = hexSessionId.data() + hexSessionId.size();
+    const auto [ptr, ec] =
+        std::from_chars(hexSessionId.data(), end, sessionId, 16);
+    if (ec != std::errc() || ptr != end || sessionId == invalidSessionId)
     {
-        if (it->second && !fs::exists(it->second->getProcPath()))
+        return std::nullopt;
+    }
+    return sessionId;
+}
+
+void SessionManager::checkSessionOwnerAlive(
+    const boost::system::error_code& ec)
+{
+    ownerCheckScheduled = false;
+    if (ec == boost::asio::error::operation_aborted)
+    {
+        return;
+    }
+
+    reapDeadOwners();
+    scheduleOwnerCheck();
+}
+
+std::size_t SessionManager::reapDeadOwners()
+{
+    LoopMonitor::Handler handlerScope(loopMonitor, "OwnerScan");
+    LatencyHistogram::Scope latencyScope(stats.ownerScanLatency);
+    RemovalBatch batch(*this, "OwnerScan");
+    std::vector<SessionIdentifier> candidates;
+    if (ownerWatcher.isSupported())
+    {
+        // The owners watched by pidfd are reaped on exit, only the ones
+        // failed to get a pidfd for are polled.
+        for (const auto pid : ownerWatcher.polledOwners())
         {
-            const auto sessionId = hexSessionId(it->first);
-            log<level::DEBUG>(
-                "Found unreachable service",
-                entry("SESSION=%s", sessionId.c_str()),
-                entry("SVC_PROC=%s", it->second->getProcPath().c_str()));
-            it = sessionItems.erase(it);
+            const auto& owned = sessionIndex.byOwnerPid(pid);
+            candidates.insert(candidates.end(), owned.begin(), owned.end());
         }
-        else
+    }
+    else
+    {
+        candidates = sessions.identifiers();
+    }
+    std::size_t count = 0U;
+    for (const auto sessionId : candidates)
+    {
+        auto record = sessions.find(sessionId);
+        if (record != nullptr &&
+            !SessionItem::isProcessAlive(record->ownerPid))
         {
-            ++it;
+            SESSION_PROBE(reap, sessionId, static_cast<int>(record->type),
+                          record->ownerPid);
+            eraseSession(*record, "OwnerScan");
+            ++count;
         }
     }
+    stats.counters.reapedByOwnerScan += count;
+    return count;
+}
+
+void SessionManager::scheduleOwnerCheck()
+{
+    if (ownerCheckScheduled || sessions.empty() ||
+        (ownerWatcher.isSupported() && !ownerWatcher.hasPolledOwners()))
+    {
+        return;
+    }
 
+    ownerCheckScheduled = true;
     timer.expires_from_now(10s);
     timer.async_wait(std::bind(&SessionManager::checkSessionOwnerAlive, this,
                                std::placeholders::_1));
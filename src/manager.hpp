@@ -5,12 +5,35 @@
 
 #pragma once
 
+#include <activity.hpp>
+#include <alloc_accounting.hpp>
+#include <audit_log.hpp>
 #include <boost/asio.hpp>
+#include <change_feed.hpp>
+#include <config.hpp>
 #include <dbus.hpp>
+#include <journal.hpp>
+#include <limiter.hpp>
+#include <loop_monitor.hpp>
+#include <owner_watcher.hpp>
+#include <sdbusplus/asio/object_server.hpp>
+#include <sdbusplus/bus/match.hpp>
+#include <session_index.hpp>
+#include <session_store.hpp>
+#include <shared_table.hpp>
+#include <stats.hpp>
+#include <timeouts.hpp>
+#include <user_cache.hpp>
+#include <virtual_objects.hpp>
 #include <xyz/openbmc_project/Session/Item/server.hpp>
 #include <xyz/openbmc_project/Session/Manager/server.hpp>
 
+#include <array>
 #include <chrono>
+#include <deque>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 namespace obmc
 {
 namespace session
@@ -22,13 +45,9 @@ using SessionManagerServer =
     sdbusplus::xyz::openbmc_project::Session::server::Manager;
 
 class SessionManager;
-class SessionItem;
-
-using SessionItemPtr = std::shared_ptr<SessionItem>;
 using SessionManagerPtr = std::shared_ptr<SessionManager>;
 using SessionManagerWeakPtr = std::weak_ptr<SessionManager>;
 
-using SessionIdentifier = std::size_t;
 using namespace obmc::dbus;
 
 class SessionManager final :
@@ -39,12 +58,37 @@ class SessionManager final :
         "xyz.openbmc_project.SessionManager";
     static constexpr const char* sessionManagerObjectPath =
         "/xyz/openbmc_project/session_manager";
+    static constexpr const char* sessionStatsObjectPath =
+        "/xyz/openbmc_project/session_manager/stats";
     static constexpr unsigned int invalidSessionId = 0U;
+    static constexpr std::size_t sessionIdLength =
+        sizeof(SessionIdentifier) * 2;
   public:
+    static constexpr const char* defaultJournalPath =
+        "/run/session-manager/sessions.journal";
+
     using SessionType = SessionItemServer::Type;
 
+    /** @brief Buffer of the NUL-terminated hex view of session ID */
+    using SessionIdBuffer = std::array<char, sessionIdLength + 1>;
+    /** @brief Buffer of the NUL-terminated session object path */
+    using ObjectPathBuffer = std::array<
+        char, std::char_traits<char>::length(sessionManagerObjectPath) + 1 +
+                  sessionIdLength + 1>;
+
+    /** @brief Errors of session operations reported without exceptions. */
+    enum class SessionError
+    {
+        none,
+        invalidSessionId,
+        unknownSession,
+        notAllowedUser,
+        quotaExceeded,
+        rateLimited,
+    };
+
     SessionManager() = delete;
-    ~SessionManager() = default;
+    ~SessionManager() override;
 
     SessionManager(const SessionManager&) = delete;
     SessionManager& operator=(const SessionManager&) = delete;
@@ -55,8 +99,18 @@ class SessionManager final :
      *
      * @param[in] bus     - Handle to system dbus
      * @param[in] ioc     - ASIO context
+     * @param[in] server  - ASIO object server to publish the manager
+     *                      extension interface
+     * @param[in] journalPath - path of the sessions journal to survive the
+     *                          service restart
+     * @param[in] auditPath   - path of the session audit ring
+     * @param[in] tablePath   - path to publish the shared session table at
      */
-    SessionManager(sdbusplus::bus::bus& bus, boost::asio::io_context& ioc);
+    SessionManager(sdbusplus::bus::bus& bus, boost::asio::io_context& ioc,
+                   sdbusplus::asio::object_server& server,
+                   const std::string& journalPath = defaultJournalPath,
+                   const std::string& auditPath = AuditLog::defaultPath,
+                   const std::string& tablePath = table::defaultPath);
 
     /** @brief Create a session and publish into the dbus.
      *
@@ -88,15 +142,70 @@ class SessionManager final :
      */
     void close(std::string sessionId) override;
 
+    /**
+     * @brief Close a dbus session by specified ID without throwing on the
+     *        expected failures.
+     *
+     * @param sessionId     - hex view of unique session ID
+     * @param cause         - the operation recorded to the audit log
+     *
+     * @return SessionError - `none` if the session has been closed
+     */
+    SessionError closeSession(std::string_view sessionId,
+                              const char* cause = "Close");
+
     /**
      * @brief Cast session id hex view to the SessionIdentifier.
      *
-     * @throw std::invalid_argument exception
-     * @throw std::out_of_range exception
+     * @return SessionIdentifier or std::nullopt if the view is malformed or
+     *         represents the reserved invalid ID.
+     */
+    static std::optional<SessionIdentifier> parseSessionId(std::string_view);
+
+    /**
+     * @brief Write the hex view of session identifier into the buffer.
      *
-     * @return SessionIdentifier
+     * @return std::string_view - the hex view placed into the buffer
+     */
+    static std::string_view formatSessionId(SessionIdentifier,
+                                            SessionIdBuffer&);
+
+    /**
+     * @brief Write the object path of session into the buffer.
+     *
+     * @return std::string_view - the object path placed into the buffer
+     */
+    static std::string_view formatSessionObjectPath(SessionIdentifier,
+                                                    ObjectPathBuffer&);
+
+    /**
+     * @brief Get the dbus error name corresponding to the session error.
+     *
+     * @return const char* - the dbus error name or empty string for `none`
+     */
+    static const char* errorName(SessionError);
+
+    /**
+     * @brief Throw the dbus error corresponding to the session error.
      */
-    static SessionIdentifier parseSessionId(const std::string&);
+    static void throwDbusError(SessionError);
+
+    /**
+     * @brief Scan the procfs for the session owner processes and close
+     *        sessions of the exited ones.
+     *
+     * @return std::size_t - count of closed sessions
+     */
+    std::size_t reapDeadOwners();
+
+    /** @brief Get the heap allocations accounting of create operations. */
+    const alloc::Stats& getCreateAllocations() const;
+
+    /** @brief Get the heap allocations accounting of close operations. */
+    const alloc::Stats& getCloseAllocations() const;
+
+    /** @brief Get the limiter of session creation requests. */
+    const CreateLimiter& getLimiter() const;
 
     /**
      * @brief Get the Session Object Path object
@@ -105,6 +214,88 @@ class SessionManager final :
      *         identifier
      */
     const std::string getSessionObjectPath(SessionIdentifier) const;
+
+    using CreateRequest =
+        std::tuple<std::string, std::string, std::string, int32_t>;
+    using CreateResult = std::tuple<std::string, std::string>;
+
+    /**
+     * @brief Create a batch of sessions within a single call.
+     *
+     * @param requests      - the list of {username, remoteAddress, type,
+     *                        callerPid} tuples of sessions to create.
+     *
+     * @return the list of {sessionId, error} tuples in order of requests. The
+     *         error is the dbus error name if the session has not been
+     *         created, otherwise it is empty.
+     */
+    std::vector<CreateResult>
+        createMany(const std::vector<CreateRequest>& requests);
+
+    /**
+     * @brief Close a batch of sessions within a single call.
+     *
+     * @param sessionIds    - the list of session IDs to close.
+     *
+     * @return the list of dbus error names in order of session IDs. The name
+     *         is empty if the session has been closed.
+     */
+    std::vector<std::string>
+        closeMany(const std::vector<std::string>& sessionIds);
+
+    /**
+     * @brief Record the activity of the sessions: restart their idle timeout
+     *        and update LastActivity. Unknown session IDs are ignored.
+     *
+     * @param sessionIds    - the list of session IDs used by the client.
+     */
+    void touch(const std::vector<std::string>& sessionIds);
+
+    /** @brief Details of sessions keyed by the session ID */
+    using SessionDetailsDict =
+        std::map<std::string, dbus::DBusSessionDetailsMap>;
+
+    using ChangesResult = std::tuple<uint64_t, bool, std::vector<std::string>,
+                                     std::vector<std::string>>;
+
+    /**
+     * @brief Get the sessions changed after the specified generation.
+     *
+     * @param since     - the generation the client is in sync with.
+     *
+     * @return the {generation, snapshot, added, removed} tuple. If the
+     *         changes since the generation are not known anymore the
+     *         snapshot flag is set and the added list holds all sessions.
+     */
+    ChangesResult getChangesSince(uint64_t since);
+
+    /**
+     * @brief Get the details of the session.
+     *
+     * @param sessionId     - the session ID.
+     *
+     * @throw InvalidArgument   - the session doesn't exist.
+     *
+     * @return the properties of the session keyed by the property name.
+     */
+    dbus::DBusSessionDetailsMap
+        getSessionDetails(const std::string& sessionId) const;
+
+    /**
+     * @brief Get the details of all sessions of the user.
+     */
+    SessionDetailsDict getSessionsByUser(const std::string& userName) const;
+
+    /**
+     * @brief Get the details of all sessions opened from the address.
+     */
+    SessionDetailsDict
+        getSessionsByRemoteAddress(const std::string& remoteAddress) const;
+
+    /**
+     * @brief Get the details of all sessions of the type.
+     */
+    SessionDetailsDict getSessionsByType(SessionType type) const;
   protected:
     friend class SessionItem;
 
@@ -113,23 +304,27 @@ class SessionManager final :
      *
      * @param userName              - the owner user name
      * @param remoteAddress         - the IP address of the session initiator.
+     * @param type                  - the session type.
      * @param[in] callerPid         - The PID of the caller to observe the
      *                                session service owner to cleanup when the
      *                                service process is down.
+     * @param[in] ownerConnection   - The unique bus name of the caller the
+     *                                session is bound to, empty if none.
      *
      * @throw logic_error           - Build new session is locked.
-     * @return SessionItemPtr       - Pointer to the Item object
+     * @return SessionRecord*       - Pointer to the session record or nullptr
+     *                                if the user isn't allowed
      */
-    SessionItemPtr create(const std::string& userName,
-                          const std::string& remoteAddress, pid_t callerPid);
+    SessionRecord* createSession(const std::string& userName,
+                                 const std::string& remoteAddress,
+                                 SessionType type, pid_t callerPid,
+                                 const std::string& ownerConnection);
 
     /**
      * @brief Remove all sessions associated with the specified user.
      *
      * @param userName      - username to close appropriate sessions
      *
-     * @throw std::runtime_error not implemented
-     *
      * @return std::size_t  - count of closed sessions
      */
     std::size_t removeAll(const std::string& userName);
@@ -140,16 +335,34 @@ class SessionManager final :
      *
      * @param remoteAddress - the IP address of the session initiator..
      *
-     * @throw std::runtime_error not implemented
-     *
      * @return std::size_t  - count of closed sessions
      */
     std::size_t removeAllByRemoteAddress(const std::string& remoteAddress);
 
     /**
-     * @brief Unconditional removes all opened sessions.
+     * @brief Remove all sessions which have been opened from addresses of the
+     *        specified network.
+     *
+     * @param network       - the network in the CIDR notation
+     *
+     * @return std::size_t  - count of closed sessions
+     *
+     * @throw InvalidArgument   - the network is malformed.
+     */
+    std::size_t removeAllByNetwork(const std::string& network);
+
+    /**
+     * @brief Get count of sessions opened from addresses of the specified
+     *        network.
      *
-     * @throw std::runtime_error not implemented
+     * @param network       - the network in the CIDR notation
+     *
+     * @throw InvalidArgument   - the network is malformed.
+     */
+    std::size_t countByNetwork(const std::string& network) const;
+
+    /**
+     * @brief Unconditional removes all opened sessions.
      *
      * @return std::size_t - count of closed sessions
      */
@@ -180,17 +393,273 @@ class SessionManager final :
 
     /**
      * @brief The callback function to check the session owner process is alive
-     *        and cleanup sessions of an unavailable service.
+     *        and cleanup sessions of an unavailable service. It is used only
+     *        when the kernel doesn't support pidfd.
      */
     void checkSessionOwnerAlive(const boost::system::error_code&);
+
+    /**
+     * @brief Arm the owners polling timer if the pidfd is not available and
+     *        there are sessions to check.
+     */
+    void scheduleOwnerCheck();
+
+    /**
+     * @brief Close all sessions owned by the specified process.
+     *
+     * @param pid           - the PID of the exited session owner.
+     *
+     * @return std::size_t  - count of closed sessions
+     */
+    std::size_t reapOwner(pid_t pid);
+
+    /**
+     * @brief Close the session which idle or absolute timeout has expired.
+     *
+     * @param sessionId     - the expired session identifier.
+     */
+    void expireSession(SessionIdentifier sessionId);
+
+    /**
+     * @brief Close the sessions of the user deleted, disabled, locked or
+     *        having the privilege changed.
+     *
+     * @param userName      - the user name.
+     *
+     * @return std::size_t - count of closed sessions
+     */
+    std::size_t revokeUserSessions(const std::string& userName);
+
+    /**
+     * @brief Close the sessions of the users which may not own them. Called
+     *        when the users are loaded, since the sessions created before
+     *        were not checked.
+     *
+     * @return std::size_t - count of closed sessions
+     */
+    std::size_t revokeDisallowedSessions();
   private:
+    /** @brief Count of session objects destroyed within a loop turn */
+    static constexpr std::size_t teardownChunkSize = 64U;
+
+    /**
+     * @brief Defers destruction of the removed session objects till the end
+     *        of the outermost batch scope. The storage is updated first and
+     *        the session objects of the whole batch are handed over to the
+     *        teardown queue afterwards. A failure of the teardown at the end
+     *        of the scope is logged and the rest of the queue is retried in
+     *        the next loop turn.
+     */
+    class RemovalBatch
+    {
+      public:
+        RemovalBatch() = delete;
+        RemovalBatch(const RemovalBatch&) = delete;
+        RemovalBatch& operator=(const RemovalBatch&) = delete;
+        RemovalBatch(RemovalBatch&&) = delete;
+        RemovalBatch& operator=(RemovalBatch&&) = delete;
+
+        /** @brief Starts the batch
+         *
+         * @param[in] manager   - the session manager
+         * @param[in] reason    - the bulk operation name reported by the
+         *                        SessionsClosed signal
+         */
+        RemovalBatch(SessionManager& manager, const char* reason);
+        ~RemovalBatch();
+
+      private:
+        SessionManager& manager;
+    };
+
+    /** @brief Session removed from the table but not from the bus yet */
+    struct Removal
+    {
+        SessionIdentifier id;
+        /** @brief The session object, empty for virtual objects */
+        SessionItemPtr object;
+    };
+
+    /** @brief Session objects removed by a bulk operation */
+    struct TeardownBatch
+    {
+        std::vector<Removal> items;
+        std::size_t released;
+        const char* reason;
+    };
+
+    /**
+     * @brief Queue the session objects of the finished batch for teardown.
+     *
+     * A batch fitting a single chunk is destroyed right away if nothing is
+     * queued before it, otherwise the objects are destroyed by chunks in the
+     * following loop turns.
+     */
+    void queueTeardown();
+
+    /**
+     * @brief Destroy the next chunk of queued session objects and emit the
+     *        SessionsClosed signal for each completed batch.
+     */
+    void tearDownChunk();
+
+    /**
+     * @brief Emit the SessionsClosed signal, a failure is logged.
+     *
+     * @param reason        - the operation which has closed the sessions
+     * @param count         - count of closed sessions
+     */
+    void emitSessionsClosed(const char* reason, std::size_t count);
+
+    /** @brief Schedule the next teardown chunk if anything is queued. */
+    void scheduleTeardown();
+
+    /**
+     * @brief Remove the session from the storage and release the owner
+     *        process observation.
+     *
+     * @param record        - the record of the session to remove
+     * @param cause         - the operation recorded to the audit log
+     */
+    void eraseSession(SessionRecord& record, const char* cause);
+
+    /**
+     * @brief Destroy the removed session object or announce the removal of
+     *        the virtual one.
+     *
+     * @param sessionId     - the session ID
+     * @param session       - the session object, empty for a virtual one
+     */
+    void releaseSession(SessionIdentifier sessionId, SessionItemPtr session);
+
+    /**
+     * @brief Build an unannounced session object with all properties set.
+     *
+     * @return SessionItemPtr   - Pointer to the Item object
+     */
+    SessionItemPtr buildSession(SessionIdentifier sessionId,
+                                const std::string& userName,
+                                const std::string& remoteAddress,
+                                SessionType type, pid_t callerPid);
+
+    /** @brief Announce the built session object on the bus. */
+    void publishSession(SessionIdentifier sessionId, SessionItem& session,
+                        SessionType type);
+
+    /**
+     * @brief Put the session into the storage, indexes and start observing
+     *        its owner process.
+     */
+    SessionRecord& insertSession(SessionIdentifier sessionId,
+                                 SessionItemPtr session,
+                                 const std::string& userName,
+                                 const std::string& remoteAddress,
+                                 SessionType type, pid_t callerPid,
+                                 const std::string& ownerConnection);
+
+    /**
+     * @brief Identify the caller of the method being handled by its sd-bus
+     *        credentials.
+     *
+     * @param[in] callerPid         - the owner PID given by the caller.
+     * @param[out] ownerConnection  - the unique bus name of the caller, left
+     *                                empty if not called over the bus.
+     *
+     * @return pid_t    - the real PID of the caller or `callerPid` if the
+     *                    credentials are not available.
+     */
+    pid_t identifyCaller(pid_t callerPid, std::string& ownerConnection);
+
+    /**
+     * @brief Close all sessions bound to the bus connection which has gone.
+     */
+    void onNameOwnerChanged(sdbusplus::message::message& message);
+
+    /**
+     * @brief Republish the sessions recorded in the journal by the previous
+     *        service instance and drop ones of the exited owners.
+     */
+    void restoreSessions();
+
+    /**
+     * @brief Close sessions of specified identifiers.
+     *
+     * @param ids           - identifiers of sessions to close. The set might
+     *                        be an index entry modified by the closing.
+     *
+     * @return std::size_t  - count of closed sessions
+     */
+    std::size_t closeSessions(const SessionIdentifierSet& ids,
+                              const char* reason);
+
+    /** @brief Close sessions of the specified identifiers. */
+    std::size_t closeSessions(const std::vector<SessionIdentifier>& ids,
+                              const char* reason);
+
+    /**
+     * @brief Collect the details of the indexed sessions.
+     */
+    SessionDetailsDict
+        collectSessionDetails(const SessionIdentifierSet& ids) const;
+
+    /**
+     * @brief Get the properties of the session keyed by the property name.
+     */
+    dbus::DBusSessionDetailsMap
+        sessionDetails(const SessionRecord& record) const;
+
+    /**
+     * @brief Emit the LastActivity change of the session object.
+     */
+    void publishActivity(const SessionRecord& record);
+
+    /**
+     * @brief Emit the SessionsChanged signal with the delta of sessions.
+     */
+    void emitSessionsChanged(ChangeFeed::Generation generation,
+                             const ChangeFeed::SessionIdentifierList& added,
+                             const ChangeFeed::SessionIdentifierList& removed);
+
+    /**
+     * @brief Format the session IDs into their hex views.
+     */
+    static std::vector<std::string>
+        formatSessionIds(const ChangeFeed::SessionIdentifierList& ids);
+
     sdbusplus::bus::bus& bus;
     boost::asio::io_context& ioc;
     std::unique_ptr<sdbusplus::server::manager::manager> dbusManager;
+    std::unique_ptr<sdbusplus::bus::match::match> connectionWatch;
+    /** @brief Real PIDs of the connections that have created sessions */
+    std::unordered_map<std::string, pid_t> connectionPids;
+    const Config config;
+    UserCache users;
+
+    std::shared_ptr<sdbusplus::asio::dbus_interface> managerIface;
 
-    using SessionItemDict = std::map<SessionIdentifier, SessionItemPtr>;
-    SessionItemDict sessionItems;
+    SessionStore sessions;
+    std::unique_ptr<VirtualSessionObjects> virtualObjects;
+    SessionIndex sessionIndex;
+    OwnerWatcher ownerWatcher;
+    std::vector<Removal> pendingRemovals;
+    const char* removalReason;
+    std::size_t removalBatchDepth;
+    std::deque<TeardownBatch> teardownQueue;
+    boost::asio::steady_timer teardownTimer;
+    bool teardownScheduled;
     boost::asio::steady_timer timer;
+    bool ownerCheckScheduled;
+    alloc::Stats createAllocations;
+    alloc::Stats closeAllocations;
+    SessionJournal journal;
+    AuditLog audit;
+    SharedSessionTable sharedTable;
+    SessionTimeouts timeouts;
+    CreateLimiter limiter;
+    SessionStats stats;
+    ChangeFeed changes;
+    ActivityTracker activity;
+    LoopMonitor loopMonitor;
 };
 } // namespace session
 } // namespace obmc
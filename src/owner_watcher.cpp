@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <owner_watcher.hpp>
+#include <phosphor-logging/log.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+namespace obmc
+{
+namespace session
+{
+
+using namespace phosphor::logging;
+
+OwnerWatcher::OwnerWatcher(boost::asio::io_context& ioc, ExitHandler handler,
+                           PollHandler pollHandler) :
+    ioc(ioc),
+    handler(std::move(handler)), pollHandler(std::move(pollHandler)),
+    nextGeneration(0U), supported(true)
+{}
+
+OwnerWatcher::WatchResult OwnerWatcher::watch(pid_t pid)
+{
+    if (!supported)
+    {
+        return WatchResult::unsupported;
+    }
+
+    auto found = watches.find(pid);
+    if (found != watches.end())
+    {
+        ++found->second->references;
+        return WatchResult::watching;
+    }
+    auto polledFound = polled.find(pid);
+    if (polledFound != polled.end())
+    {
+        ++polledFound->second;
+        return WatchResult::polled;
+    }
+
+    if (pid <= 0)
+    {
+        return WatchResult::gone;
+    }
+
+    const int fd = static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+    if (fd < 0)
+    {
+        const int error = errno;
+        if (error == ENOSYS)
+        {
+            log<level::INFO>("The pidfd is not supported by the kernel, "
+                             "fallback to poll the session owners.");
+            supported = false;
+            return WatchResult::unsupported;
+        }
+        if (error == ESRCH)
+        {
+            return WatchResult::gone;
+        }
+        // The process is alive, but the descriptor can't be had now (e.g.
+        // EMFILE), so its sessions are kept and the process is polled.
+        log<level::WARNING>("Failure to open pidfd of the session owner, "
+                            "fallback to poll it",
+                            entry("PID=%d", pid),
+                            entry("ERROR=%s", std::strerror(error)));
+        polled.emplace(pid, 1U);
+        return WatchResult::polled;
+    }
+
+    auto watch = std::make_unique<Watch>(ioc, fd, nextGeneration++);
+    arm(pid, *watch);
+    watches.emplace(pid, std::move(watch));
+    return WatchResult::watching;
+}
+
+void OwnerWatcher::unwatch(pid_t pid)
+{
+    auto polledFound = polled.find(pid);
+    if (polledFound != polled.end())
+    {
+        if (--polledFound->second == 0U)
+        {
+            polled.erase(polledFound);
+        }
+        return;
+    }
+    auto found = watches.find(pid);
+    if (found == watches.end())
+    {
+        return;
+    }
+    if (--found->second->references == 0U)
+    {
+        // Closing the descriptor cancels the pending wait operation.
+        watches.erase(found);
+    }
+}
+
+bool OwnerWatcher::isSupported() const
+{
+    return supported;
+}
+
+std::vector<pid_t> OwnerWatcher::polledOwners() const
+{
+    std::vector<pid_t> pids;
+    pids.reserve(polled.size());
+    for (const auto& [pid, references] : polled)
+    {
+        pids.push_back(pid);
+    }
+    return pids;
+}
+
+bool OwnerWatcher::hasPolledOwners() const
+{
+    return !polled.empty();
+}
+
+void OwnerWatcher::arm(pid_t pid, Watch& watch)
+{
+    watch.descriptor.async_wait(
+        boost::asio::posix::descriptor_base::wait_read,
+        [this, pid, generation = watch.generation](
+            const boost::system::error_code& ec) {
+            if (ec == boost::asio::error::operation_aborted)
+            {
+                return;
+            }
+            auto found = watches.find(pid);
+            if (found == watches.end() ||
+                found->second->generation != generation)
+            {
+                // The completion has been queued before the watch was
+                // released, so the PID is no longer of interest.
+                return;
+            }
+            if (ec)
+            {
+                // The failed wait tells nothing about the process, so its
+                // liveness is left to the poll.
+                log<level::ERR>("Failure to wait for the session owner, "
+                                "fallback to poll it",
+                                entry("PID=%d", pid),
+                                entry("ERROR=%s", ec.message().c_str()));
+                polled.emplace(pid, found->second->references);
+                watches.erase(found);
+                pollHandler();
+                return;
+            }
+            watches.erase(found);
+            handler(pid);
+        });
+}
+
+} // namespace session
+} // namespace obmc
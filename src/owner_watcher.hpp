@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <boost/asio.hpp>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace obmc
+{
+namespace session
+{
+
+/**
+ * @brief Observes session owner processes through pidfd descriptors.
+ *
+ * Each distinct PID is watched by a single pidfd registered within the
+ * service event loop, no matter how many sessions the process owns. The
+ * descriptor becomes readable as soon as the process exits, so the owner death
+ * is reported without polling the procfs.
+ */
+class OwnerWatcher
+{
+  public:
+    using ExitHandler = std::function<void(pid_t)>;
+    using PollHandler = std::function<void()>;
+
+    enum class WatchResult
+    {
+        watching,
+        gone,
+        unsupported,
+        polled,
+    };
+
+    OwnerWatcher() = delete;
+    OwnerWatcher(const OwnerWatcher&) = delete;
+    OwnerWatcher& operator=(const OwnerWatcher&) = delete;
+    OwnerWatcher(OwnerWatcher&&) = delete;
+    OwnerWatcher& operator=(OwnerWatcher&&) = delete;
+    ~OwnerWatcher() = default;
+
+    /** @brief Constructs the owner processes watcher
+     *
+     * @param[in] ioc       - ASIO context
+     * @param[in] handler   - the callback to invoke when a watched process
+     *                        exits.
+     * @param[in] pollHandler - the callback to invoke when a watched process
+     *                          can no longer be waited for and must be
+     *                          polled.
+     */
+    OwnerWatcher(boost::asio::io_context& ioc, ExitHandler handler,
+                 PollHandler pollHandler);
+
+    /**
+     * @brief Start observing the specified process. Each call must be paired
+     *        with the `unwatch()` call for the same PID.
+     *
+     * @param pid           - the PID of the session owner process.
+     *
+     * @return WatchResult  - `watching` if the process is observed,
+     *                        `gone` if the process doesn't exist,
+     *                        `unsupported` if the kernel has no pidfd support
+     *                        and `polled` if the pidfd can't be opened now,
+     *                        e.g. for the descriptors limit, so the process
+     *                        must be polled by the caller.
+     */
+    WatchResult watch(pid_t pid);
+
+    /**
+     * @brief Release a reference of the observed process and stop watching it
+     *        when the last reference is gone.
+     *
+     * @param pid           - the PID of the session owner process.
+     */
+    void unwatch(pid_t pid);
+
+    /**
+     * @brief Check whether the owner processes are observed via pidfd.
+     *
+     * @return true if the pidfd is available.
+     */
+    bool isSupported() const;
+
+    /**
+     * @brief Get the processes which are watched without pidfd and must be
+     *        polled.
+     *
+     * @return PIDs of the polled processes.
+     */
+    std::vector<pid_t> polledOwners() const;
+
+    /**
+     * @brief Check whether there are processes to poll.
+     *
+     * @return true if any process is watched without pidfd.
+     */
+    bool hasPolledOwners() const;
+
+  private:
+    struct Watch
+    {
+        Watch(boost::asio::io_context& ioc, int fd, std::size_t generation) :
+            descriptor(ioc, fd), references(1U), generation(generation)
+        {}
+
+        boost::asio::posix::stream_descriptor descriptor;
+        std::size_t references;
+        std::size_t generation;
+    };
+
+    void arm(pid_t pid, Watch& watch);
+
+    boost::asio::io_context& ioc;
+    ExitHandler handler;
+    PollHandler pollHandler;
+    std::unordered_map<pid_t, std::unique_ptr<Watch>> watches;
+    /** @brief References of the processes failed to get or wait a pidfd */
+    std::unordered_map<pid_t, std::size_t> polled;
+    std::size_t nextGeneration;
+    bool supported;
+};
+
+} // namespace session
+} // namespace obmc
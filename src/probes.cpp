@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <probes.hpp>
+
+// The semaphores are placed to the `.probes` section, where the tracers look
+// them up by the addresses recorded in the probe notes.
+#define SESSION_PROBE_DEFINE(name)                                            \
+    __attribute__((section(".probes"))) volatile unsigned short               \
+        SESSION_PROBE_SEMAPHORE(name) = 0U
+
+extern "C"
+{
+    SESSION_PROBE_DEFINE(create_entry);
+    SESSION_PROBE_DEFINE(create_return);
+    SESSION_PROBE_DEFINE(close_entry);
+    SESSION_PROBE_DEFINE(close_return);
+    SESSION_PROBE_DEFINE(reap);
+    SESSION_PROBE_DEFINE(close_all_by_type_entry);
+    SESSION_PROBE_DEFINE(close_all_by_type_return);
+    SESSION_PROBE_DEFINE(object_added);
+    SESSION_PROBE_DEFINE(object_removed);
+}
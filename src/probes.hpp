@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * The static tracepoints of the session manager.
+ *
+ * The build with `-Dusdt=true` places the SystemTap SDT probes of the
+ * `session_manager` provider into the code: each probe site is a single nop
+ * instruction until perf, bpftrace or SystemTap attaches to it. The durations
+ * reported by the `*_return` probes are only measured while the probe has a
+ * tracer attached, which the tracer signals through the probe semaphore. In
+ * the default build the probes expand to nothing.
+ *
+ * | Probe                     | Arguments                                  |
+ * |---------------------------|--------------------------------------------|
+ * | create_entry              | type, caller PID                           |
+ * | create_return             | session ID (0 - rejected), type, ns        |
+ * | close_entry               | session ID (0 - malformed)                 |
+ * | close_return              | session ID, error, ns                      |
+ * | reap                      | session ID, type, owner PID                |
+ * | close_all_by_type_entry   | type                                       |
+ * | close_all_by_type_return  | type, closed sessions, ns                  |
+ * | object_added              | session ID, type, ns                       |
+ * | object_removed            | session ID, ns                             |
+ */
+#ifdef SESSION_MANAGER_USDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define SESSION_PROBE_SEMAPHORE(name) session_manager_##name##_semaphore
+
+#define SESSION_PROBE(name, ...) STAP_PROBEV(session_manager, name, __VA_ARGS__)
+
+#define SESSION_PROBE_ENABLED(name)                                           \
+    __builtin_expect(SESSION_PROBE_SEMAPHORE(name) != 0U, 0)
+
+// The semaphores are counted up by the tracers attached to the probes.
+extern "C"
+{
+    extern volatile unsigned short SESSION_PROBE_SEMAPHORE(create_entry);
+    extern volatile unsigned short SESSION_PROBE_SEMAPHORE(create_return);
+    extern volatile unsigned short SESSION_PROBE_SEMAPHORE(close_entry);
+    extern volatile unsigned short SESSION_PROBE_SEMAPHORE(close_return);
+    extern volatile unsigned short SESSION_PROBE_SEMAPHORE(reap);
+    extern volatile unsigned short SESSION_PROBE_SEMAPHORE(
+        close_all_by_type_entry);
+    extern volatile unsigned short SESSION_PROBE_SEMAPHORE(
+        close_all_by_type_return);
+    extern volatile unsigned short SESSION_PROBE_SEMAPHORE(object_added);
+    extern volatile unsigned short SESSION_PROBE_SEMAPHORE(object_removed);
+}
+
+#else
+
+#define SESSION_PROBE(name, ...) obmc::session::discardProbe(__VA_ARGS__)
+
+#define SESSION_PROBE_ENABLED(name) false
+
+#endif
+
+namespace obmc
+{
+namespace session
+{
+
+#ifndef SESSION_MANAGER_USDT
+/**
+ * @brief Stands for a disabled probe. The arguments are plain values, so the
+ *        call is optimized out, the probe only keeps them used.
+ */
+template <typename... Args>
+inline void discardProbe(const Args&...) noexcept
+{}
+#endif
+
+/**
+ * @brief Measures the duration of a traced operation. The clock is only read
+ *        while the probe reporting the duration is traced.
+ */
+class ProbeTimer
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    ProbeTimer() = delete;
+    ProbeTimer(const ProbeTimer&) = delete;
+    ProbeTimer& operator=(const ProbeTimer&) = delete;
+    ProbeTimer(ProbeTimer&&) = delete;
+    ProbeTimer& operator=(ProbeTimer&&) = delete;
+
+    /** @param[in] enabled - SESSION_PROBE_ENABLED() of the reporting probe */
+    explicit ProbeTimer(bool enabled) :
+        start(enabled ? Clock::now() : Clock::time_point())
+    {}
+
+    /** @brief Get nanoseconds elapsed since the construction, 0 if the probe
+     *         was not traced at that moment.
+     */
+    uint64_t elapsed() const
+    {
+        if (start == Clock::time_point())
+        {
+            return 0U;
+        }
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                 start)
+                .count());
+    }
+
+  private:
+    Clock::time_point start;
+};
+
+} // namespace session
+} // namespace obmc
@@ -5,8 +5,11 @@
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
 #include <session.hpp>
+#include <user_cache.hpp>
 
-#include <iostream>
+#include <charconv>
+#include <cstring>
+#include <limits>
 
 namespace obmc
 {
@@ -15,6 +18,72 @@ namespace session
 
 using namespace phosphor::logging;
 
+const sdbusplus::vtable::vtable_t SessionItemExt::vtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::property("RemainingLifetime", "t",
+                                SessionItemExt::getRemainingLifetime),
+    sdbusplus::vtable::property("LastActivity", "t",
+                                SessionItemExt::getLastActivity,
+                                sdbusplus::vtable::property_::emits_change),
+    sdbusplus::vtable::end()};
+
+SessionItemExt::SessionItemExt(sdbusplus::bus::bus& bus, const char* objPath) :
+    expiry(Clock::time_point::max()), lastActivity(0U),
+    extIface(bus, objPath, session_item::interface, vtable, this)
+{}
+
+void SessionItemExt::setExpiry(Clock::time_point expiry)
+{
+    this->expiry = expiry;
+}
+
+uint64_t SessionItemExt::remainingLifetime() const
+{
+    return secondsTill(expiry);
+}
+
+void SessionItemExt::setLastActivity(uint64_t lastActivity)
+{
+    this->lastActivity = lastActivity;
+}
+
+void SessionItemExt::emitLastActivity()
+{
+    extIface.property_changed("LastActivity");
+}
+
+uint64_t SessionItemExt::secondsTill(Clock::time_point expiry)
+{
+    if (expiry == Clock::time_point::max())
+    {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    const auto now = Clock::now();
+    if (expiry <= now)
+    {
+        return 0U;
+    }
+    return static_cast<uint64_t>(
+        std::chrono::ceil<std::chrono::seconds>(expiry - now).count());
+}
+
+int SessionItemExt::getRemainingLifetime(sd_bus*, const char*, const char*,
+                                         const char*, sd_bus_message* reply,
+                                         void* context, sd_bus_error*)
+{
+    const uint64_t value =
+        static_cast<SessionItemExt*>(context)->remainingLifetime();
+    return sd_bus_message_append_basic(reply, 't', &value);
+}
+
+int SessionItemExt::getLastActivity(sd_bus*, const char*, const char*,
+                                    const char*, sd_bus_message* reply,
+                                    void* context, sd_bus_error*)
+{
+    const uint64_t value = static_cast<SessionItemExt*>(context)->lastActivity;
+    return sd_bus_message_append_basic(reply, 't', &value);
+}
+
 void SessionItem::setSessionMetadata(std::string username,
                                      std::string remoteIPAddr)
 {
@@ -26,20 +95,79 @@ void SessionItem::setSessionMetadata(std::string username,
     this->remoteIPAddr(remoteIPAddr);
 }
 
-void SessionItem::adjustSessionOwner(const std::string& userName)
+void SessionItem::publish()
 {
-    // skip publish session for the `root`
-    if (userName == "root")
+    // The InterfacesAdded signal carries all interfaces hosted by the object
+    // path. It is emitted on behalf of the Association Definitions object
+    // because that one is destroyed first, so the paired InterfacesRemoved
+    // signal covers both interfaces as well.
+    AssocDefinitionServerObject::emit_object_added();
+}
+
+void SessionItem::adjustSessionOwner(const std::string& userName,
+                                     bool skipSignal)
+{
+    if (!isAllowedOwner(userName))
     {
         throw UnknownUser();
     }
-    this->username(userName);
+    this->username(userName, skipSignal);
+    this->associations(getUserAssociations(userName), skipSignal);
+}
+
+dbus::UserAssociationList
+    SessionItem::getUserAssociations(const std::string& userName)
+{
+    if (userName.empty())
+    {
+        return {};
+    }
+    return {{"user", "session", UserCache::getUserObjectPath(userName)}};
+}
+
+bool SessionItem::isAllowedOwner(const std::string& userName)
+{
+    // skip publish session for the `root`
+    return userName != "root";
 }
 
 const std::string SessionItem::getProcPath() const
 {
-    return "/proc/" + std::to_string(ownerPid);
+    ProcPathBuffer buffer;
+    return std::string(formatProcPath(ownerPid, buffer));
+}
+
+bool SessionItem::isOwnerAlive() const
+{
+    return isProcessAlive(ownerPid);
+}
+
+bool SessionItem::isProcessAlive(pid_t pid)
+{
+    ProcPathBuffer buffer;
+    formatProcPath(pid, buffer);
+    return ::access(buffer.data(), F_OK) == 0;
+}
+
+std::string_view SessionItem::formatProcPath(pid_t pid,
+                                             ProcPathBuffer& buffer)
+{
+    constexpr std::string_view procPrefix = "/proc/";
+    std::memcpy(buffer.data(), procPrefix.data(), procPrefix.size());
+    const auto [end, ec] =
+        std::to_chars(buffer.data() + procPrefix.size(),
+                      buffer.data() + buffer.size() - 1U, pid);
+    // The buffer is large enough to hold any pid_t value.
+    *end = '\0';
+    return std::string_view(buffer.data(),
+                            static_cast<std::size_t>(end - buffer.data()));
 }
+
+pid_t SessionItem::getOwnerPid() const
+{
+    return ownerPid;
+}
+
 const std::string SessionItem::getOwner() const
 {
     return this->username();
@@ -54,8 +182,13 @@ const std::string
 SessionIdentifier
     SessionItem::retrieveIdFromObjectPath(const std::string& objectPath)
 {
-    return SessionManager::parseSessionId(
+    const auto sessionId = SessionManager::parseSessionId(
         dbus::utils::getLastSegmentFromObjectPath(objectPath));
+    if (!sessionId)
+    {
+        throw InvalidArgument();
+    }
+    return *sessionId;
 }
 
 } // namespace session
@@ -10,6 +10,10 @@
 #include <phosphor-logging/log.hpp>
 #include <xyz/openbmc_project/Association/Definitions/server.hpp>
 
+#include <array>
+#include <chrono>
+#include <string_view>
+
 namespace obmc
 {
 namespace session
@@ -32,7 +36,88 @@ class UnknownUser : public std::logic_error
     ~UnknownUser() override = default;
 };
 
+/**
+ * @brief The `com.yadro.Session.Item` interface of the session object, which
+ *        extends the Session Item with the manager-side session state.
+ */
+class SessionItemExt
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    SessionItemExt() = delete;
+    SessionItemExt(const SessionItemExt&) = delete;
+    SessionItemExt& operator=(const SessionItemExt&) = delete;
+    SessionItemExt(SessionItemExt&&) = delete;
+    SessionItemExt& operator=(SessionItemExt&&) = delete;
+    virtual ~SessionItemExt() = default;
+
+    /** @brief Constructs the extension interface of Session Item.
+     *
+     * @param[in] bus               - Handle to system dbus
+     * @param[in] objPath           - The Dbus path that hosts Session Item.
+     */
+    SessionItemExt(sdbusplus::bus::bus& bus, const char* objPath);
+
+    /**
+     * @brief Set the time the session expires at.
+     *
+     * @param expiry    - the expiry time or Clock::time_point::max if the
+     *                    session never expires.
+     */
+    void setExpiry(Clock::time_point expiry);
+
+    /**
+     * @brief Get the remaining lifetime of the session in seconds.
+     *
+     * @return uint64_t - seconds till the session expiry or UINT64_MAX if
+     *                    the session never expires.
+     */
+    uint64_t remainingLifetime() const;
+
+    /**
+     * @brief Set the last activity time of the session silently.
+     *
+     * @param lastActivity  - microseconds since the epoch
+     */
+    void setLastActivity(uint64_t lastActivity);
+
+    /** @brief Emit the PropertiesChanged signal of LastActivity. */
+    void emitLastActivity();
+
+    /**
+     * @brief Get the seconds remaining till the expiry.
+     *
+     * @return uint64_t - seconds till the expiry or UINT64_MAX if the expiry
+     *                    is Clock::time_point::max.
+     */
+    static uint64_t secondsTill(Clock::time_point expiry);
+
+  private:
+    static int getRemainingLifetime(sd_bus* bus, const char* path,
+                                    const char* interface,
+                                    const char* property,
+                                    sd_bus_message* reply, void* context,
+                                    sd_bus_error* error);
+
+    static int getLastActivity(sd_bus* bus, const char* path,
+                               const char* interface, const char* property,
+                               sd_bus_message* reply, void* context,
+                               sd_bus_error* error);
+
+    static const sdbusplus::vtable::vtable_t vtable[];
+
+    Clock::time_point expiry;
+    uint64_t lastActivity;
+    sdbusplus::server::interface::interface extIface;
+};
+
+/**
+ * The extension interface is the first base, so it outlives the other
+ * interfaces and is listed by the InterfacesRemoved signal of the object.
+ */
 class SessionItem :
+    public SessionItemExt,
     public SessionItemServerObject,
     public AssocDefinitionServerObject
 {
@@ -44,16 +129,20 @@ class SessionItem :
     SessionItem& operator=(SessionItem&&) = default;
 
     /** @brief Constructs dbus-object-server of Session Item.
+     *
+     * The object isn't announced on the bus until `publish()` is called, so
+     * the properties can be filled in without emitting signals.
      *
      * @param[in] bus               - Handle to system dbus
      * @param[in] objPath           - The Dbus path that hosts Session Item.
-     * @param[in] managerPtr        - The pointer of manager.
+     * @param[in] ownerPid          - The PID of the session owner process.
      */
-    SessionItem(sdbusplus::bus::bus& bus, const std::string& objPath,
+    SessionItem(sdbusplus::bus::bus& bus, const char* objPath,
                 pid_t ownerPid) :
-        SessionItemServerObject(bus, objPath.c_str()),
-        AssocDefinitionServerObject(bus, objPath.c_str()), bus(bus),
-        path(objPath), ownerPid(ownerPid)
+        SessionItemExt(bus, objPath),
+        SessionItemServerObject(bus, objPath, true),
+        AssocDefinitionServerObject(bus, objPath, true), bus(bus),
+        ownerPid(ownerPid)
     {
         // Nothing to do here
     }
@@ -68,16 +157,44 @@ class SessionItem :
      */
     void setSessionMetadata(std::string username, std::string remoteIPAddr);
 
+    /**
+     * @brief Announce the session object with all its interfaces by a single
+     *        InterfacesAdded signal.
+     */
+    void publish();
+
     /**
      * @brief Associate user of specified username with the current session.
      *
      * @param userName          - the user name to associate with the
      *                            current session.
+     * @param skipSignal        - don't emit the PropertiesChanged signal.
      *
      * @throw std::exception    failure on set user object relation to
      *                          the current session
      */
-    void adjustSessionOwner(const std::string& userName);
+    void adjustSessionOwner(const std::string& userName,
+                            bool skipSignal = false);
+
+    /**
+     * @brief Check whether the user is allowed to own a session.
+     *
+     * @param userName          - the user name to check.
+     *
+     * @return true if the session might be published for the user.
+     */
+    static bool isAllowedOwner(const std::string& userName);
+
+    /**
+     * @brief Get the associations of the session with its owner user.
+     *
+     * @param userName          - the session owner user name.
+     *
+     * @return dbus::UserAssociationList - the user association or an empty
+     *                                     list if the session has no owner.
+     */
+    static dbus::UserAssociationList
+        getUserAssociations(const std::string& userName);
 
     /**
      * @brief Get the full proc path of session owner process.
@@ -86,6 +203,29 @@ class SessionItem :
      */
     const std::string getProcPath() const;
 
+    /**
+     * @brief Check whether the session owner process exists.
+     *
+     * @return true if the proc entry of session owner process exists.
+     */
+    bool isOwnerAlive() const;
+
+    /**
+     * @brief Check whether the process exists.
+     *
+     * @param pid       - the process ID
+     *
+     * @return true if the proc entry of the process exists.
+     */
+    static bool isProcessAlive(pid_t pid);
+
+    /**
+     * @brief Get the PID of session owner process.
+     *
+     * @return pid_t    - the session owner PID
+     */
+    pid_t getOwnerPid() const;
+
     /**
      * @brief Get the session owner username
      *
@@ -102,9 +242,12 @@ class SessionItem :
         retrieveIdFromObjectPath(const std::string& objectPath);
 
   private:
+    /** @brief Buffer of the NUL-terminated proc path of the owner process */
+    using ProcPathBuffer = std::array<char, 32>;
+
+    static std::string_view formatProcPath(pid_t pid, ProcPathBuffer& buffer);
+
     sdbusplus::bus::bus& bus;
-    /** @brief Path of the group instance */
-    const std::string path;
     pid_t ownerPid;
 };
 
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <session_index.hpp>
+
+namespace obmc
+{
+namespace session
+{
+
+void SessionIndex::insert(SessionIdentifier id, const std::string& userName,
+                          const std::string& remoteAddress, SessionType type,
+                          pid_t ownerPid, const std::string& ownerConnection)
+{
+    users[userName].insert(id);
+    if (const auto address = parseAddress(remoteAddress))
+    {
+        addresses.insert(*address, id);
+    }
+    else
+    {
+        otherAddresses[remoteAddress].insert(id);
+    }
+    types[type].insert(id);
+    owners[ownerPid].insert(id);
+    if (!ownerConnection.empty())
+    {
+        connections[ownerConnection].insert(id);
+    }
+}
+
+void SessionIndex::erase(SessionIdentifier id, const std::string& userName,
+                         const std::string& remoteAddress, SessionType type,
+                         pid_t ownerPid, const std::string& ownerConnection)
+{
+    unlink(users, userName, id);
+    if (const auto address = parseAddress(remoteAddress))
+    {
+        addresses.erase(*address, id);
+    }
+    else
+    {
+        unlink(otherAddresses, remoteAddress, id);
+    }
+    unlink(types, type, id);
+    unlink(owners, ownerPid, id);
+    if (!ownerConnection.empty())
+    {
+        unlink(connections, ownerConnection, id);
+    }
+}
+
+const SessionIdentifierSet&
+    SessionIndex::byUser(const std::string& userName) const
+{
+    return lookup(users, userName);
+}
+
+std::vector<std::string> SessionIndex::userNames() const
+{
+    std::vector<std::string> names;
+    names.reserve(users.size());
+    for (const auto& [userName, ids] : users)
+    {
+        names.push_back(userName);
+    }
+    return names;
+}
+
+const SessionIdentifierSet&
+    SessionIndex::byRemoteAddress(const std::string& remoteAddress) const
+{
+    static const SessionIdentifierSet emptySet;
+    if (const auto address = parseAddress(remoteAddress))
+    {
+        const auto found = addresses.find(*address);
+        return found != nullptr ? *found : emptySet;
+    }
+    return lookup(otherAddresses, remoteAddress);
+}
+
+std::vector<SessionIdentifier>
+    SessionIndex::byNetwork(const Network& network) const
+{
+    return addresses.collect(network);
+}
+
+std::size_t SessionIndex::countByNetwork(const Network& network) const
+{
+    return addresses.count(network);
+}
+
+const SessionIdentifierSet& SessionIndex::byType(SessionType type) const
+{
+    return lookup(types, type);
+}
+
+const SessionIdentifierSet& SessionIndex::byOwnerPid(pid_t ownerPid) const
+{
+    return lookup(owners, ownerPid);
+}
+
+const SessionIdentifierSet&
+    SessionIndex::byOwnerConnection(const std::string& ownerConnection) const
+{
+    return lookup(connections, ownerConnection);
+}
+
+template <typename Key>
+void SessionIndex::unlink(Index<Key>& index, const Key& key,
+                          SessionIdentifier id)
+{
+    auto found = index.find(key);
+    if (found == index.end())
+    {
+        return;
+    }
+    found->second.erase(id);
+    if (found->second.empty())
+    {
+        index.erase(found);
+    }
+}
+
+template <typename Key>
+const SessionIdentifierSet& SessionIndex::lookup(const Index<Key>& index,
+                                                 const Key& key)
+{
+    static const SessionIdentifierSet emptySet;
+    auto found = index.find(key);
+    return found == index.end() ? emptySet : found->second;
+}
+
+} // namespace session
+} // namespace obmc
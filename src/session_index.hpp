@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <address_tree.hpp>
+#include <xyz/openbmc_project/Session/Item/server.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace obmc
+{
+namespace session
+{
+
+/**
+ * @brief Secondary indexes of the session storage.
+ *
+ * The session is unindexed by the keys it was indexed with at the creation,
+ * which the session store keeps regardless of the current values of the
+ * session dbus properties. The IP remote addresses are indexed in the binary
+ * form, so all spellings of an address match the same sessions.
+ */
+class SessionIndex
+{
+  public:
+    using SessionType =
+        sdbusplus::xyz::openbmc_project::Session::server::Item::Type;
+
+    /**
+     * @brief Add the session into all indexes.
+     *
+     * @param id            - the session identifier
+     * @param userName      - the session owner user name
+     * @param remoteAddress - the IP address of the session initiator
+     * @param type          - the session type
+     * @param ownerPid      - the PID of the session owner process
+     * @param ownerConnection - the unique bus name of the session owner,
+     *                          empty if the session isn't bound to one
+     */
+    void insert(SessionIdentifier id, const std::string& userName,
+                const std::string& remoteAddress, SessionType type,
+                pid_t ownerPid, const std::string& ownerConnection);
+
+    /**
+     * @brief Remove the session from all indexes.
+     *
+     * @param id            - the session identifier
+     * @param userName      - the session owner user name
+     * @param remoteAddress - the IP address of the session initiator
+     * @param type          - the session type
+     * @param ownerPid      - the PID of the session owner process
+     * @param ownerConnection - the unique bus name of the session owner,
+     *                          empty if the session isn't bound to one
+     */
+    void erase(SessionIdentifier id, const std::string& userName,
+               const std::string& remoteAddress, SessionType type,
+               pid_t ownerPid, const std::string& ownerConnection);
+
+    /** @brief Get identifiers of sessions owned by the specified user. */
+    const SessionIdentifierSet& byUser(const std::string& userName) const;
+
+    /** @brief Get names of the users owning any session. */
+    std::vector<std::string> userNames() const;
+
+    /** @brief Get identifiers of sessions opened from the specified address. */
+    const SessionIdentifierSet&
+        byRemoteAddress(const std::string& remoteAddress) const;
+
+    /** @brief Get identifiers of sessions opened from the network. */
+    std::vector<SessionIdentifier> byNetwork(const Network& network) const;
+
+    /** @brief Get count of sessions opened from the network. */
+    std::size_t countByNetwork(const Network& network) const;
+
+    /** @brief Get identifiers of sessions of the specified type. */
+    const SessionIdentifierSet& byType(SessionType type) const;
+
+    /** @brief Get identifiers of sessions owned by the specified process. */
+    const SessionIdentifierSet& byOwnerPid(pid_t ownerPid) const;
+
+    /** @brief Get identifiers of sessions bound to the bus connection. */
+    const SessionIdentifierSet&
+        byOwnerConnection(const std::string& ownerConnection) const;
+
+  private:
+    template <typename Key>
+    using Index = std::unordered_map<Key, SessionIdentifierSet>;
+
+    template <typename Key>
+    static void unlink(Index<Key>& index, const Key& key,
+                       SessionIdentifier id);
+
+    template <typename Key>
+    static const SessionIdentifierSet& lookup(const Index<Key>& index,
+                                              const Key& key);
+
+    Index<std::string> users;
+    AddressTree addresses;
+    /** @brief The remote addresses which are not IP addresses */
+    Index<std::string> otherAddresses;
+    Index<SessionType> types;
+    Index<pid_t> owners;
+    Index<std::string> connections;
+};
+
+} // namespace session
+} // namespace obmc
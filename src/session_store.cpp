@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <address_tree.hpp>
+#include <session.hpp>
+#include <session_store.hpp>
+
+namespace obmc
+{
+namespace session
+{
+
+StringInterner::Handle StringInterner::acquire(const std::string& value)
+{
+    auto [it, inserted] = references.try_emplace(value, 0U);
+    ++it->second;
+    return &it->first;
+}
+
+void StringInterner::release(Handle handle)
+{
+    auto found = references.find(*handle);
+    if (found != references.end() && --found->second == 0U)
+    {
+        references.erase(found);
+    }
+}
+
+std::size_t StringInterner::size() const
+{
+    return references.size();
+}
+
+SessionStore::SessionStore() : slots(minCapacity, nullptr), count(0U)
+{}
+
+// The records own the session objects, which are complete here only.
+SessionStore::~SessionStore() = default;
+
+SessionRecord& SessionStore::insert(SessionIdentifier id,
+                                    const std::string& userName,
+                                    const std::string& remoteAddress,
+                                    SessionType type, pid_t ownerPid,
+                                    const std::string& ownerConnection,
+                                    SessionItemPtr object)
+{
+    // Keep the load factor under 1/2, so the probe sequences stay short.
+    if ((count + 1U) * 2U > slots.size())
+    {
+        rehash(slots.size() * 2U);
+    }
+
+    auto record = allocate();
+    record->id = id;
+    record->userName = strings.acquire(userName);
+    record->rawAddress = nullptr;
+    record->ownerConnection =
+        ownerConnection.empty() ? nullptr : strings.acquire(ownerConnection);
+    record->ownerPid = ownerPid;
+    record->type = type;
+    record->activityPending = false;
+    record->lastActivity = 0U;
+    record->object = std::move(object);
+
+    const auto address = parseAddress(remoteAddress);
+    record->address = address ? *address : in6_addr{};
+    if (!address || formatAddress(*address) != remoteAddress)
+    {
+        // Not an IP address or not its canonical form, keep it as is.
+        record->rawAddress = strings.acquire(remoteAddress);
+    }
+
+    slots[probe(id)] = record;
+    ++count;
+    return *record;
+}
+
+SessionRecord* SessionStore::find(SessionIdentifier id) const
+{
+    return slots[probe(id)];
+}
+
+SessionItemPtr SessionStore::erase(SessionRecord& record)
+{
+    const std::size_t mask = slots.size() - 1U;
+    std::size_t hole = probe(record.id);
+    slots[hole] = nullptr;
+    --count;
+
+    // Shift the following records of the cluster back into the hole, so the
+    // table never needs tombstones.
+    for (std::size_t next = (hole + 1U) & mask; slots[next] != nullptr;
+         next = (next + 1U) & mask)
+    {
+        const std::size_t start = home(slots[next]->id);
+        const bool movable = (next > hole) ? (start <= hole || start > next)
+                                           : (start <= hole && start > next);
+        if (movable)
+        {
+            slots[hole] = slots[next];
+            slots[next] = nullptr;
+            hole = next;
+        }
+    }
+
+    strings.release(record.userName);
+    if (record.rawAddress != nullptr)
+    {
+        strings.release(record.rawAddress);
+    }
+    if (record.ownerConnection != nullptr)
+    {
+        strings.release(record.ownerConnection);
+    }
+    auto object = std::move(record.object);
+    freeRecords.push_back(&record);
+    return object;
+}
+
+bool SessionStore::contains(SessionIdentifier id) const
+{
+    return find(id) != nullptr;
+}
+
+std::size_t SessionStore::size() const
+{
+    return count;
+}
+
+bool SessionStore::empty() const
+{
+    return count == 0U;
+}
+
+std::vector<SessionIdentifier> SessionStore::identifiers() const
+{
+    std::vector<SessionIdentifier> result;
+    result.reserve(count);
+    for (const auto record : slots)
+    {
+        if (record != nullptr)
+        {
+            result.push_back(record->id);
+        }
+    }
+    return result;
+}
+
+std::string SessionStore::getRemoteAddress(const SessionRecord& record)
+{
+    if (record.rawAddress != nullptr)
+    {
+        return *record.rawAddress;
+    }
+    return formatAddress(record.address);
+}
+
+std::size_t SessionStore::memoryUsage() const
+{
+    return slots.capacity() * sizeof(SessionRecord*) +
+           pool.size() * poolChunkSize * sizeof(SessionRecord) +
+           freeRecords.capacity() * sizeof(SessionRecord*);
+}
+
+SessionRecord* SessionStore::allocate()
+{
+    if (freeRecords.empty())
+    {
+        pool.emplace_back(std::make_unique<SessionRecord[]>(poolChunkSize));
+        auto chunk = pool.back().get();
+        for (std::size_t i = poolChunkSize; i > 0U; --i)
+        {
+            freeRecords.push_back(&chunk[i - 1U]);
+        }
+    }
+    auto record = freeRecords.back();
+    freeRecords.pop_back();
+    return record;
+}
+
+std::size_t SessionStore::home(SessionIdentifier id) const
+{
+    // The session IDs are hashes already, yet mix the bits to spread the
+    // sequential ones.
+    uint64_t hash = id;
+    hash ^= hash >> 33U;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33U;
+    return static_cast<std::size_t>(hash) & (slots.size() - 1U);
+}
+
+std::size_t SessionStore::probe(SessionIdentifier id) const
+{
+    const std::size_t mask = slots.size() - 1U;
+    std::size_t slot = home(id);
+    while (slots[slot] != nullptr && slots[slot]->id != id)
+    {
+        slot = (slot + 1U) & mask;
+    }
+    return slot;
+}
+
+void SessionStore::rehash(std::size_t capacity)
+{
+    std::vector<SessionRecord*> previous(capacity, nullptr);
+    previous.swap(slots);
+    for (const auto record : previous)
+    {
+        if (record != nullptr)
+        {
+            slots[probe(record->id)] = record;
+        }
+    }
+}
+
+} // namespace session
+} // namespace obmc
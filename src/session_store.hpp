@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <netinet/in.h>
+#include <sys/types.h>
+
+#include <session_index.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace obmc
+{
+namespace session
+{
+
+class SessionItem;
+using SessionItemPtr = std::unique_ptr<SessionItem>;
+
+/**
+ * @brief Reference-counted storage of strings shared by many sessions.
+ */
+class StringInterner
+{
+  public:
+    /** @brief Stable pointer to the interned string */
+    using Handle = const std::string*;
+
+    /**
+     * @brief Get the interned copy of the string and take a reference.
+     */
+    Handle acquire(const std::string& value);
+
+    /**
+     * @brief Drop the reference taken by `acquire()`.
+     */
+    void release(Handle handle);
+
+    /** @brief Get count of distinct interned strings. */
+    std::size_t size() const;
+
+  private:
+    std::unordered_map<std::string, std::size_t> references;
+};
+
+/**
+ * @brief The session record of the store.
+ *
+ * The remote address is kept in the binary form of `parseAddress()` and
+ * rendered by `formatAddress()` on read. The addresses which can't be
+ * reproduced from the binary form exactly are kept interned as they were
+ * given.
+ */
+struct SessionRecord
+{
+    using SessionType = SessionIndex::SessionType;
+
+    SessionIdentifier id;
+    StringInterner::Handle userName;
+    StringInterner::Handle rawAddress;
+    in6_addr address;
+    /** @brief Unique bus name of the owner, nullptr if the session is not
+     *         bound to a connection */
+    StringInterner::Handle ownerConnection;
+    pid_t ownerPid;
+    SessionType type;
+    /** @brief The LastActivity change is queued for publication */
+    bool activityPending;
+    std::chrono::steady_clock::time_point expiry;
+    /** @brief The last activity time, microseconds since the epoch */
+    uint64_t lastActivity;
+    /** @brief The dbus object of the session, empty for virtual objects */
+    SessionItemPtr object;
+};
+
+/**
+ * @brief Compact storage of sessions.
+ *
+ * The records are allocated from a pool by chunks and indexed by an
+ * open-addressing hash table with linear probing, so a session costs a
+ * record and a pointer slot. User names are interned and remote addresses
+ * are stored parsed.
+ */
+class SessionStore
+{
+  public:
+    using SessionType = SessionRecord::SessionType;
+
+    SessionStore();
+    SessionStore(const SessionStore&) = delete;
+    SessionStore& operator=(const SessionStore&) = delete;
+    SessionStore(SessionStore&&) = delete;
+    SessionStore& operator=(SessionStore&&) = delete;
+    ~SessionStore();
+
+    /**
+     * @brief Add the session record.
+     *
+     * @return SessionRecord&   - the record of the session
+     */
+    SessionRecord& insert(SessionIdentifier id, const std::string& userName,
+                          const std::string& remoteAddress, SessionType type,
+                          pid_t ownerPid, const std::string& ownerConnection,
+                          SessionItemPtr object);
+
+    /**
+     * @brief Find the session record.
+     *
+     * @return SessionRecord*   - the record or nullptr if not found
+     */
+    SessionRecord* find(SessionIdentifier id) const;
+
+    /**
+     * @brief Remove the session record.
+     *
+     * @return SessionItemPtr   - the dbus object of the removed session
+     */
+    SessionItemPtr erase(SessionRecord& record);
+
+    /** @brief Check whether the session exists. */
+    bool contains(SessionIdentifier id) const;
+
+    /** @brief Get count of sessions. */
+    std::size_t size() const;
+
+    /** @brief Check whether there are no sessions. */
+    bool empty() const;
+
+    /** @brief Get identifiers of all sessions. */
+    std::vector<SessionIdentifier> identifiers() const;
+
+    /** @brief Render the remote address of the session. */
+    static std::string getRemoteAddress(const SessionRecord& record);
+
+    /** @brief Get approximate count of bytes used by the store. */
+    std::size_t memoryUsage() const;
+
+  private:
+    static constexpr std::size_t poolChunkSize = 64U;
+    static constexpr std::size_t minCapacity = 16U;
+
+    /** @brief Take a free record from the pool. */
+    SessionRecord* allocate();
+
+    /** @brief Get the slot to start probing for the session from. */
+    std::size_t home(SessionIdentifier id) const;
+
+    /** @brief Get the slot of the session or the empty slot to put it. */
+    std::size_t probe(SessionIdentifier id) const;
+
+    /** @brief Rehash the records into a table of the specified capacity. */
+    void rehash(std::size_t capacity);
+
+    std::vector<SessionRecord*> slots;
+    std::size_t count;
+    std::vector<std::unique_ptr<SessionRecord[]>> pool;
+    std::vector<SessionRecord*> freeRecords;
+    StringInterner strings;
+};
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,358 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <phosphor-logging/log.hpp>
+#include <shared_table.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+
+namespace obmc
+{
+namespace session
+{
+
+using namespace phosphor::logging;
+
+namespace fs = std::filesystem;
+
+SharedSessionTable::SharedSessionTable(const std::string& path,
+                                       std::size_t capacity) :
+    path(path),
+    tempPath(path + ".new"), mapping(nullptr),
+    capacity(std::bit_ceil(static_cast<uint32_t>(
+        std::clamp<std::size_t>(capacity, minCapacity, maxCapacity)))),
+    published(false)
+{
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    mapping = create(this->capacity, tempPath);
+}
+
+void* SharedSessionTable::create(uint32_t slots,
+                                 const std::string& filePath) const
+{
+    const int fd = ::open(filePath.c_str(),
+                          O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0)
+    {
+        log<level::ERR>("Failure to create the session table",
+                        entry("PATH=%s", filePath.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+        return nullptr;
+    }
+    const auto size = table::fileSize(slots);
+    void* newMapping = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(size)) == 0)
+    {
+        newMapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                            fd, 0);
+    }
+    ::close(fd);
+    if (newMapping == MAP_FAILED)
+    {
+        log<level::ERR>("Failure to map the session table",
+                        entry("PATH=%s", filePath.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+        ::unlink(filePath.c_str());
+        return nullptr;
+    }
+
+    // The file is zeroed, so all slots are empty. The magic is written
+    // last, so a reader never sees a partial header.
+    auto& newHeader = *static_cast<table::Header*>(newMapping);
+    newHeader.version = table::version;
+    newHeader.capacity = slots;
+    newHeader.entrySize = sizeof(table::Entry);
+    newHeader.flags = table::flagComplete;
+    std::atomic_ref<uint32_t>(newHeader.magic)
+        .store(table::magic, std::memory_order_release);
+    return newMapping;
+}
+
+bool SharedSessionTable::grow()
+{
+    if (capacity >= maxCapacity)
+    {
+        return false;
+    }
+    // The new table is built aside, as the unpublished table being replaced
+    // is still at the temporary path.
+    const auto newCapacity = capacity * 2U;
+    const auto growPath = path + ".grow";
+    void* newMapping = create(newCapacity, growPath);
+    if (newMapping == nullptr)
+    {
+        return false;
+    }
+    if (std::rename(growPath.c_str(), tempPath.c_str()) != 0)
+    {
+        log<level::ERR>("Failure to replace the session table",
+                        entry("PATH=%s", tempPath.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+        ::munmap(newMapping, table::fileSize(newCapacity));
+        ::unlink(growPath.c_str());
+        return false;
+    }
+
+    // The readers of the old table ask the service until it is retired.
+    setComplete(false);
+    void* oldMapping = std::exchange(mapping, newMapping);
+    const auto oldCapacity = std::exchange(capacity, newCapacity);
+    const auto oldEntries = reinterpret_cast<const table::Entry*>(
+        static_cast<uint8_t*>(oldMapping) + sizeof(table::Header));
+    uint32_t count = 0U;
+    for (uint32_t slot = 0U; slot < oldCapacity; ++slot)
+    {
+        if (oldEntries[slot].id != 0U)
+        {
+            entries()[vacant(oldEntries[slot].id)] = oldEntries[slot];
+            ++count;
+        }
+    }
+    header().count = count;
+    for (auto it = dropped.begin(); it != dropped.end() && fits();)
+    {
+        entries()[vacant(it->first)] = it->second;
+        ++header().count;
+        it = dropped.erase(it);
+    }
+    if (!dropped.empty())
+    {
+        setComplete(false);
+    }
+    ::munmap(oldMapping, table::fileSize(oldCapacity));
+
+    log<level::INFO>("Grown the session table",
+                     entry("CAPACITY=%u", capacity),
+                     entry("SESSIONS=%u", header().count));
+    if (published)
+    {
+        published = false;
+        publish();
+    }
+    return true;
+}
+
+SharedSessionTable::~SharedSessionTable()
+{
+    if (mapping == nullptr)
+    {
+        return;
+    }
+    setComplete(false);
+    ::munmap(mapping, table::fileSize(capacity));
+    if (!published)
+    {
+        ::unlink(tempPath.c_str());
+    }
+}
+
+void SharedSessionTable::publish()
+{
+    if (mapping == nullptr)
+    {
+        return;
+    }
+
+    // The readers of the replaced table are told to reopen the path.
+    table::Header* replaced = nullptr;
+    const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        table::Header old{};
+        if (::pread(fd, &old, sizeof(old), 0) == sizeof(old) &&
+            old.magic == table::magic)
+        {
+            void* oldMapping = ::mmap(nullptr, sizeof(old),
+                                      PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                                      0);
+            if (oldMapping != MAP_FAILED)
+            {
+                replaced = static_cast<table::Header*>(oldMapping);
+            }
+        }
+        ::close(fd);
+    }
+
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        log<level::ERR>("Failure to publish the session table",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+    }
+    else
+    {
+        published = true;
+    }
+
+    if (replaced != nullptr)
+    {
+        if (published)
+        {
+            std::atomic_ref<uint32_t>(replaced->flags)
+                .fetch_or(table::flagRetired, std::memory_order_release);
+        }
+        ::munmap(replaced, sizeof(table::Header));
+    }
+}
+
+void SharedSessionTable::insert(SessionIdentifier id,
+                                std::string_view userName, uint8_t type,
+                                pid_t ownerPid)
+{
+    if (mapping == nullptr)
+    {
+        return;
+    }
+    table::Entry session{};
+    session.id = id;
+    session.ownerPid = ownerPid;
+    session.type = type;
+    std::memcpy(session.userName, userName.data(),
+                std::min(userName.size(), sizeof(session.userName)));
+
+    if (!fits() && !grow())
+    {
+        if (dropped.empty())
+        {
+            log<level::WARNING>("The session table is full",
+                                entry("CAPACITY=%u", capacity));
+            setComplete(false);
+        }
+        dropped.emplace(id, session);
+        return;
+    }
+
+    const auto slot = vacant(id);
+    beginChange();
+    entries()[slot] = session;
+    ++header().count;
+    endChange();
+}
+
+void SharedSessionTable::erase(SessionIdentifier id)
+{
+    if (mapping == nullptr)
+    {
+        return;
+    }
+    auto hole = find(id);
+    if (hole == capacity)
+    {
+        // The session didn't fit in the table.
+        if (dropped.erase(id) != 0U && dropped.empty())
+        {
+            setComplete(true);
+        }
+        return;
+    }
+
+    beginChange();
+    // Shift back the entries of the probe sequence running through the
+    // hole, so the lookups never need tombstones.
+    const auto mask = capacity - 1U;
+    for (auto slot = (hole + 1U) & mask; entries()[slot].id != 0U;
+         slot = (slot + 1U) & mask)
+    {
+        const auto home = table::home(entries()[slot].id, capacity);
+        const bool reachable = hole < slot ? (hole < home && home <= slot)
+                                           : (hole < home || home <= slot);
+        if (!reachable)
+        {
+            entries()[hole] = entries()[slot];
+            hole = slot;
+        }
+    }
+    entries()[hole] = table::Entry{};
+    --header().count;
+    endChange();
+}
+
+void SharedSessionTable::beginChange()
+{
+    std::atomic_ref<uint32_t> sequence(header().sequence);
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1U,
+                   std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void SharedSessionTable::endChange()
+{
+    std::atomic_ref<uint32_t> sequence(header().sequence);
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1U,
+                   std::memory_order_release);
+}
+
+table::Header& SharedSessionTable::header() const
+{
+    return *static_cast<table::Header*>(mapping);
+}
+
+table::Entry* SharedSessionTable::entries() const
+{
+    return reinterpret_cast<table::Entry*>(static_cast<uint8_t*>(mapping) +
+                                           sizeof(table::Header));
+}
+
+uint32_t SharedSessionTable::find(SessionIdentifier id) const
+{
+    auto slot = table::home(id, capacity);
+    for (uint32_t probed = 0U; probed < capacity; ++probed)
+    {
+        if (entries()[slot].id == id)
+        {
+            return slot;
+        }
+        if (entries()[slot].id == 0U)
+        {
+            break;
+        }
+        slot = (slot + 1U) & (capacity - 1U);
+    }
+    return capacity;
+}
+
+uint32_t SharedSessionTable::vacant(SessionIdentifier id) const
+{
+    auto slot = table::home(id, capacity);
+    while (entries()[slot].id != 0U)
+    {
+        slot = (slot + 1U) & (capacity - 1U);
+    }
+    return slot;
+}
+
+bool SharedSessionTable::fits() const
+{
+    // Keep the load factor under 3/4, so the probe sequences stay short.
+    return (header().count + 1U) * 4U <= capacity * 3U;
+}
+
+void SharedSessionTable::setComplete(bool complete)
+{
+    beginChange();
+    std::atomic_ref<uint32_t> flags(header().flags);
+    if (complete)
+    {
+        flags.fetch_or(table::flagComplete, std::memory_order_relaxed);
+    }
+    else
+    {
+        flags.fetch_and(~table::flagComplete, std::memory_order_relaxed);
+    }
+    endChange();
+}
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <session_table.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace obmc
+{
+namespace session
+{
+
+using SessionIdentifier = std::size_t;
+
+/**
+ * @brief Writer of the session table shared with the local consumers.
+ *
+ * The table is built in a temporary file and replaces the published one by
+ * `publish()`, the replaced table is marked retired so its readers reopen the
+ * path. The table which reaches its load limit is rebuilt twice as large and
+ * republished the same way. Only if it can't grow, the sessions which don't
+ * fit make it incomplete until they are closed or placed by a later growth.
+ * The table is disabled if the file can't be mapped.
+ *
+ * See `include/session_table.hpp` for the layout and the reader.
+ */
+class SharedSessionTable
+{
+  public:
+    /** @brief The default count of slots, which holds 3072 sessions */
+    static constexpr uint32_t defaultCapacity = 4096U;
+    /** @brief The least count of slots */
+    static constexpr uint32_t minCapacity = 16U;
+    /** @brief The count of slots the table never grows beyond, 64 MiB */
+    static constexpr uint32_t maxCapacity = 1U << 20U;
+
+    SharedSessionTable() = delete;
+    SharedSessionTable(const SharedSessionTable&) = delete;
+    SharedSessionTable& operator=(const SharedSessionTable&) = delete;
+    SharedSessionTable(SharedSessionTable&&) = delete;
+    SharedSessionTable& operator=(SharedSessionTable&&) = delete;
+
+    /** @brief Creates the unpublished empty table.
+     *
+     * @param[in] path      - the path to publish the table at
+     * @param[in] capacity  - initial count of slots, rounded up to the power
+     *                        of two
+     */
+    explicit SharedSessionTable(const std::string& path,
+                                std::size_t capacity = defaultCapacity);
+
+    /** @brief Marks the table incomplete, so readers ask the service. */
+    ~SharedSessionTable();
+
+    /** @brief Replace the table at the path by this one. */
+    void publish();
+
+    /**
+     * @brief Add the session to the table.
+     *
+     * @param[in] id        - the session ID
+     * @param[in] userName  - the session owner user name
+     * @param[in] type      - the session type
+     * @param[in] ownerPid  - the session owner PID
+     */
+    void insert(SessionIdentifier id, std::string_view userName, uint8_t type,
+                pid_t ownerPid);
+
+    /** @brief Remove the session from the table. */
+    void erase(SessionIdentifier id);
+
+  private:
+    /** @brief Start the change, the readers retry until `endChange()`. */
+    void beginChange();
+    void endChange();
+
+    /**
+     * @brief Create the empty table file and map it.
+     *
+     * @param[in] slots     - count of slots, the power of two
+     * @param[in] filePath  - the file to create
+     *
+     * @return void* - the mapping, nullptr on failure.
+     */
+    void* create(uint32_t slots, const std::string& filePath) const;
+
+    /**
+     * @brief Move the sessions to the table twice as large and republish it
+     *        if the current one is published.
+     *
+     * @return true if the table has grown.
+     */
+    bool grow();
+
+    table::Header& header() const;
+    table::Entry* entries() const;
+
+    /** @brief Get the slot of the session, capacity if not found. */
+    uint32_t find(SessionIdentifier id) const;
+
+    /** @brief Get the empty slot to place the session to. */
+    uint32_t vacant(SessionIdentifier id) const;
+
+    /** @brief Check whether one more session keeps the load under 3/4. */
+    bool fits() const;
+
+    /** @brief Tell the readers whether every session is in the table. */
+    void setComplete(bool complete);
+
+    std::string path;
+    std::string tempPath;
+    void* mapping;
+    uint32_t capacity;
+    /** @brief The sessions which didn't fit in the table */
+    std::unordered_map<SessionIdentifier, table::Entry> dropped;
+    bool published;
+};
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <dbus.hpp>
+#include <stats.hpp>
+
+#include <malloc.h>
+
+#include <algorithm>
+
+namespace obmc
+{
+namespace session
+{
+
+using namespace obmc::dbus;
+
+namespace
+{
+constexpr std::array<SessionStats::SessionType, 6> sessionTypes = {
+    SessionStats::SessionType::Redfish,
+    SessionStats::SessionType::HostConsole,
+    SessionStats::SessionType::ManagerConsole,
+    SessionStats::SessionType::IPMI,
+    SessionStats::SessionType::KVMIP,
+    SessionStats::SessionType::VirtualMedia,
+};
+} // namespace
+
+void LatencyHistogram::record(Clock::duration duration)
+{
+    const auto usec = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration)
+            .count());
+    const auto bucket =
+        std::lower_bound(bounds.begin(), bounds.end(), usec) - bounds.begin();
+    ++counts[static_cast<std::size_t>(bucket)];
+}
+
+const LatencyHistogram::Counts& LatencyHistogram::getCounts() const
+{
+    return counts;
+}
+
+const sdbusplus::vtable::vtable_t SessionStats::vtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::property(
+        "Creates", "t", SessionStats::getCounter<&StatsCounters::creates>),
+    sdbusplus::vtable::property(
+        "Closes", "t", SessionStats::getCounter<&StatsCounters::closes>),
+    sdbusplus::vtable::property(
+        "RejectedNotAllowed", "t",
+        SessionStats::getCounter<&StatsCounters::rejectedNotAllowed>),
+    sdbusplus::vtable::property("RejectedByQuota", "t",
+                                SessionStats::getRejectedByQuota),
+    sdbusplus::vtable::property("RejectedByRate", "t",
+                                SessionStats::getRejectedByRate),
+    sdbusplus::vtable::property(
+        "ReapedOnOwnerExit", "t",
+        SessionStats::getCounter<&StatsCounters::reapedOnOwnerExit>),
+    sdbusplus::vtable::property(
+        "ReapedByOwnerScan", "t",
+        SessionStats::getCounter<&StatsCounters::reapedByOwnerScan>),
+    sdbusplus::vtable::property(
+        "ReapedOnDisconnect", "t",
+        SessionStats::getCounter<&StatsCounters::reapedOnDisconnect>),
+    sdbusplus::vtable::property(
+        "Expired", "t", SessionStats::getCounter<&StatsCounters::expired>),
+    sdbusplus::vtable::property(
+        "RevokedOnUserChange", "t",
+        SessionStats::getCounter<&StatsCounters::revokedOnUserChange>),
+    sdbusplus::vtable::property(
+        "CloseAllByTypeCalls", "t",
+        SessionStats::getCounter<&StatsCounters::closeAllByTypeCalls>),
+    sdbusplus::vtable::property(
+        "SlowHandlers", "t",
+        SessionStats::getCounter<&StatsCounters::slowHandlers>),
+    sdbusplus::vtable::property("Sessions", "a{st}",
+                                SessionStats::getSessions),
+    sdbusplus::vtable::property("HeapInUse", "t", SessionStats::getHeapInUse),
+    sdbusplus::vtable::property("LatencyBounds", "at",
+                                SessionStats::getLatencyBounds),
+    sdbusplus::vtable::property(
+        "CreateLatency", "at",
+        SessionStats::getHistogram<&SessionStats::createLatency>),
+    sdbusplus::vtable::property(
+        "CloseLatency", "at",
+        SessionStats::getHistogram<&SessionStats::closeLatency>),
+    sdbusplus::vtable::property(
+        "OwnerScanLatency", "at",
+        SessionStats::getHistogram<&SessionStats::ownerScanLatency>),
+    sdbusplus::vtable::property(
+        "LoopLag", "at", SessionStats::getHistogram<&SessionStats::loopLag>),
+    sdbusplus::vtable::end()};
+
+SessionStats::SessionStats(sdbusplus::bus::bus& bus, const char* objPath,
+                           const SessionIndex& index,
+                           const CreateLimiter& limiter) :
+    index(index),
+    limiter(limiter),
+    statsIface(bus, objPath, session_stats::interface, vtable, this)
+{}
+
+template <uint64_t StatsCounters::*counter>
+int SessionStats::getCounter(sd_bus*, const char*, const char*, const char*,
+                             sd_bus_message* reply, void* context,
+                             sd_bus_error*)
+{
+    const auto& counters = static_cast<SessionStats*>(context)->counters;
+    return sd_bus_message_append_basic(reply, 't', &(counters.*counter));
+}
+
+template <LatencyHistogram SessionStats::*histogram>
+int SessionStats::getHistogram(sd_bus*, const char*, const char*, const char*,
+                               sd_bus_message* reply, void* context,
+                               sd_bus_error*)
+{
+    const auto& counts =
+        (static_cast<SessionStats*>(context)->*histogram).getCounts();
+    return sd_bus_message_append_array(reply, 't', counts.data(),
+                                       sizeof(counts));
+}
+
+int SessionStats::getRejectedByQuota(sd_bus*, const char*, const char*,
+                                     const char*, sd_bus_message* reply,
+                                     void* context, sd_bus_error*)
+{
+    const uint64_t value =
+        static_cast<SessionStats*>(context)->limiter.getQuotaRejections();
+    return sd_bus_message_append_basic(reply, 't', &value);
+}
+
+int SessionStats::getRejectedByRate(sd_bus*, const char*, const char*,
+                                    const char*, sd_bus_message* reply,
+                                    void* context, sd_bus_error*)
+{
+    const uint64_t value =
+        static_cast<SessionStats*>(context)->limiter.getRateRejections();
+    return sd_bus_message_append_basic(reply, 't', &value);
+}
+
+int SessionStats::getSessions(sd_bus*, const char*, const char*, const char*,
+                              sd_bus_message* reply, void* context,
+                              sd_bus_error*)
+{
+    const auto& index = static_cast<SessionStats*>(context)->index;
+    int rc = sd_bus_message_open_container(reply, 'a', "{st}");
+    for (auto type : sessionTypes)
+    {
+        if (rc < 0)
+        {
+            return rc;
+        }
+        const auto name =
+            sdbusplus::xyz::openbmc_project::Session::server::Item::
+                convertTypeToString(type);
+        const uint64_t count = index.byType(type).size();
+        rc = sd_bus_message_append(reply, "{st}", name.c_str(), count);
+    }
+    if (rc < 0)
+    {
+        return rc;
+    }
+    return sd_bus_message_close_container(reply);
+}
+
+int SessionStats::getHeapInUse(sd_bus*, const char*, const char*, const char*,
+                               sd_bus_message* reply, void*, sd_bus_error*)
+{
+    // The heap usage includes the whole service, yet the session table is
+    // the only structure growing with the load.
+    const struct mallinfo2 info = ::mallinfo2();
+    const uint64_t value = info.uordblks + info.hblkhd;
+    return sd_bus_message_append_basic(reply, 't', &value);
+}
+
+int SessionStats::getLatencyBounds(sd_bus*, const char*, const char*,
+                                   const char*, sd_bus_message* reply, void*,
+                                   sd_bus_error*)
+{
+    return sd_bus_message_append_array(reply, 't',
+                                       LatencyHistogram::bounds.data(),
+                                       sizeof(LatencyHistogram::bounds));
+}
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <limiter.hpp>
+#include <sdbusplus/server.hpp>
+#include <session_index.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace obmc
+{
+namespace session
+{
+
+/**
+ * @brief Latency histogram with fixed buckets.
+ *
+ * The bucket `i` counts operations lasted up to `bounds[i]` microseconds, the
+ * last bucket counts the ones lasted longer than all bounds.
+ */
+class LatencyHistogram
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::array<uint64_t, 15> bounds = {
+        1U,    2U,    5U,     10U,    20U,    50U,    100U,   200U,
+        500U,  1000U, 2000U,  5000U,  10000U, 50000U, 100000U};
+
+    using Counts = std::array<uint64_t, bounds.size() + 1>;
+
+    /**
+     * @brief Measures the lifetime of the scope into the histogram.
+     */
+    class Scope
+    {
+      public:
+        Scope() = delete;
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        Scope(Scope&&) = delete;
+        Scope& operator=(Scope&&) = delete;
+
+        explicit Scope(LatencyHistogram& histogram) :
+            histogram(histogram), start(Clock::now())
+        {}
+
+        ~Scope()
+        {
+            histogram.record(Clock::now() - start);
+        }
+
+      private:
+        LatencyHistogram& histogram;
+        Clock::time_point start;
+    };
+
+    /** @brief Count the operation of the specified duration. */
+    void record(Clock::duration duration);
+
+    /** @brief Get the operations count per bucket. */
+    const Counts& getCounts() const;
+
+  private:
+    Counts counts{};
+};
+
+/**
+ * @brief Event counters of the session manager.
+ */
+struct StatsCounters
+{
+    uint64_t creates = 0U;
+    uint64_t closes = 0U;
+    uint64_t rejectedNotAllowed = 0U;
+    uint64_t reapedOnOwnerExit = 0U;
+    uint64_t reapedByOwnerScan = 0U;
+    uint64_t reapedOnDisconnect = 0U;
+    uint64_t expired = 0U;
+    uint64_t revokedOnUserChange = 0U;
+    uint64_t closeAllByTypeCalls = 0U;
+    uint64_t slowHandlers = 0U;
+};
+
+/**
+ * @brief The `com.yadro.Session.Stats` object of the session manager.
+ *
+ * The counters and histograms are plain integers updated by the event loop
+ * thread. The properties are evaluated on each read only, so no signals are
+ * emitted and the updates cost nothing more than an increment. The gauges
+ * are taken from the session index and never walk the session table.
+ */
+class SessionStats
+{
+  public:
+    using SessionType = SessionIndex::SessionType;
+
+    SessionStats() = delete;
+    SessionStats(const SessionStats&) = delete;
+    SessionStats& operator=(const SessionStats&) = delete;
+    SessionStats(SessionStats&&) = delete;
+    SessionStats& operator=(SessionStats&&) = delete;
+    ~SessionStats() = default;
+
+    /** @brief Constructs the statistics object
+     *
+     * @param[in] bus       - Handle to system dbus
+     * @param[in] objPath   - The Dbus path that hosts the statistics
+     * @param[in] index     - the index of existing sessions
+     * @param[in] limiter   - the limiter of session creation requests
+     */
+    SessionStats(sdbusplus::bus::bus& bus, const char* objPath,
+                 const SessionIndex& index, const CreateLimiter& limiter);
+
+    StatsCounters counters;
+    LatencyHistogram createLatency;
+    LatencyHistogram closeLatency;
+    LatencyHistogram ownerScanLatency;
+    LatencyHistogram loopLag;
+
+  private:
+    template <uint64_t StatsCounters::*counter>
+    static int getCounter(sd_bus* bus, const char* path,
+                          const char* interface, const char* property,
+                          sd_bus_message* reply, void* context,
+                          sd_bus_error* error);
+
+    template <LatencyHistogram SessionStats::*histogram>
+    static int getHistogram(sd_bus* bus, const char* path,
+                            const char* interface, const char* property,
+                            sd_bus_message* reply, void* context,
+                            sd_bus_error* error);
+
+    static int getRejectedByQuota(sd_bus* bus, const char* path,
+                                  const char* interface, const char* property,
+                                  sd_bus_message* reply, void* context,
+                                  sd_bus_error* error);
+
+    static int getRejectedByRate(sd_bus* bus, const char* path,
+                                 const char* interface, const char* property,
+                                 sd_bus_message* reply, void* context,
+                                 sd_bus_error* error);
+
+    static int getSessions(sd_bus* bus, const char* path,
+                           const char* interface, const char* property,
+                           sd_bus_message* reply, void* context,
+                           sd_bus_error* error);
+
+    static int getHeapInUse(sd_bus* bus, const char* path,
+                            const char* interface, const char* property,
+                            sd_bus_message* reply, void* context,
+                            sd_bus_error* error);
+
+    static int getLatencyBounds(sd_bus* bus, const char* path,
+                                const char* interface, const char* property,
+                                sd_bus_message* reply, void* context,
+                                sd_bus_error* error);
+
+    static const sdbusplus::vtable::vtable_t vtable[];
+
+    const SessionIndex& index;
+    const CreateLimiter& limiter;
+    sdbusplus::server::interface::interface statsIface;
+};
+
+} // namespace session
+} // namespace obmc
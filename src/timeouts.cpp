@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <timeouts.hpp>
+
+namespace obmc
+{
+namespace session
+{
+
+using namespace std::chrono_literals;
+
+SessionTimeouts::SessionTimeouts(boost::asio::io_context& ioc,
+                                 const Config& config, ExpireHandler handler) :
+    config(config),
+    handler(std::move(handler)), timer(ioc), tickScheduled(false),
+    wheel(currentTick())
+{}
+
+SessionTimeouts::Clock::time_point
+    SessionTimeouts::arm(SessionIdentifier id, SessionType type)
+{
+    const auto& typeConfig = config.forType(type);
+    if (typeConfig.idleTimeout == 0s && typeConfig.absoluteTimeout == 0s)
+    {
+        return Clock::time_point::max();
+    }
+
+    const auto now = Clock::now();
+    const auto absolute = typeConfig.absoluteTimeout == 0s
+                              ? Clock::time_point::max()
+                              : now + typeConfig.absoluteTimeout;
+    deadlines[id] = Deadlines{typeConfig.idleTimeout, absolute};
+
+    const auto idle = typeConfig.idleTimeout == 0s
+                          ? Clock::time_point::max()
+                          : now + typeConfig.idleTimeout;
+    return schedule(id, std::min(idle, absolute));
+}
+
+SessionTimeouts::Clock::time_point
+    SessionTimeouts::touch(SessionIdentifier id)
+{
+    auto found = deadlines.find(id);
+    if (found == deadlines.end())
+    {
+        return Clock::time_point::max();
+    }
+    const auto& sessionDeadlines = found->second;
+    if (sessionDeadlines.idleTimeout == 0s)
+    {
+        return sessionDeadlines.absolute;
+    }
+    return schedule(id, std::min(Clock::now() + sessionDeadlines.idleTimeout,
+                                 sessionDeadlines.absolute));
+}
+
+void SessionTimeouts::cancel(SessionIdentifier id)
+{
+    if (deadlines.erase(id) != 0U)
+    {
+        wheel.cancel(id);
+    }
+}
+
+SessionTimeouts::Wheel::Tick SessionTimeouts::toTick(Clock::time_point time)
+{
+    // Round up, so the session never expires earlier than requested.
+    const auto sinceEpoch = time.time_since_epoch();
+    auto seconds = std::chrono::ceil<std::chrono::seconds>(sinceEpoch);
+    return static_cast<Wheel::Tick>(seconds.count());
+}
+
+SessionTimeouts::Wheel::Tick SessionTimeouts::currentTick()
+{
+    const auto sinceEpoch = Clock::now().time_since_epoch();
+    auto seconds = std::chrono::floor<std::chrono::seconds>(sinceEpoch);
+    return static_cast<Wheel::Tick>(seconds.count());
+}
+
+SessionTimeouts::Clock::time_point
+    SessionTimeouts::schedule(SessionIdentifier id, Clock::time_point expiry)
+{
+    wheel.schedule(id, toTick(expiry), currentTick());
+    scheduleTick();
+    return expiry;
+}
+
+void SessionTimeouts::scheduleTick()
+{
+    if (tickScheduled || wheel.empty())
+    {
+        return;
+    }
+    tickScheduled = true;
+    timer.expires_from_now(1s);
+    timer.async_wait(std::bind(&SessionTimeouts::onTick, this,
+                               std::placeholders::_1));
+}
+
+void SessionTimeouts::onTick(const boost::system::error_code& ec)
+{
+    tickScheduled = false;
+    if (ec == boost::asio::error::operation_aborted)
+    {
+        return;
+    }
+
+    std::vector<SessionIdentifier> expired;
+    wheel.advance(currentTick(), expired);
+    for (const auto id : expired)
+    {
+        deadlines.erase(id);
+        handler(id);
+    }
+    scheduleTick();
+}
+
+} // namespace session
+} // namespace obmc
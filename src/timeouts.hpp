@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <config.hpp>
+#include <timer_wheel.hpp>
+
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+
+namespace obmc
+{
+namespace session
+{
+
+using SessionIdentifier = std::size_t;
+
+/**
+ * @brief Tracks the idle and absolute timeouts of sessions.
+ *
+ * All sessions share a single timer wheel driven by one steady timer of the
+ * event loop with the second resolution. The steady timer is armed only while
+ * there are sessions to expire.
+ */
+class SessionTimeouts
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+    using SessionType = Config::SessionType;
+    using ExpireHandler = std::function<void(SessionIdentifier)>;
+
+    SessionTimeouts() = delete;
+    SessionTimeouts(const SessionTimeouts&) = delete;
+    SessionTimeouts& operator=(const SessionTimeouts&) = delete;
+    SessionTimeouts(SessionTimeouts&&) = delete;
+    SessionTimeouts& operator=(SessionTimeouts&&) = delete;
+    ~SessionTimeouts() = default;
+
+    /** @brief Constructs the session timeouts tracker
+     *
+     * @param[in] ioc       - ASIO context
+     * @param[in] config    - the session manager configuration
+     * @param[in] handler   - the callback to invoke for an expired session
+     */
+    SessionTimeouts(boost::asio::io_context& ioc, const Config& config,
+                    ExpireHandler handler);
+
+    /**
+     * @brief Arm the timeouts of a new session according to its type.
+     *
+     * @return Clock::time_point - the session expiry or Clock::time_point::max
+     *                             if the session never expires.
+     */
+    Clock::time_point arm(SessionIdentifier id, SessionType type);
+
+    /**
+     * @brief Restart the idle timeout of the session.
+     *
+     * @return Clock::time_point - the new session expiry or
+     *                             Clock::time_point::max if the session never
+     *                             expires.
+     */
+    Clock::time_point touch(SessionIdentifier id);
+
+    /**
+     * @brief Disarm the timeouts of the session.
+     */
+    void cancel(SessionIdentifier id);
+
+  private:
+    using Wheel = TimerWheel<SessionIdentifier>;
+
+    struct Deadlines
+    {
+        std::chrono::seconds idleTimeout;
+        Clock::time_point absolute;
+    };
+
+    static Wheel::Tick toTick(Clock::time_point time);
+    static Wheel::Tick currentTick();
+    Clock::time_point schedule(SessionIdentifier id, Clock::time_point expiry);
+    void scheduleTick();
+    void onTick(const boost::system::error_code& ec);
+
+    const Config& config;
+    ExpireHandler handler;
+    boost::asio::steady_timer timer;
+    bool tickScheduled;
+    std::unordered_map<SessionIdentifier, Deadlines> deadlines;
+    Wheel wheel;
+};
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace obmc
+{
+namespace session
+{
+
+/**
+ * @brief Hierarchical timer wheel of keyed timers.
+ *
+ * The time is measured in abstract ticks. Each level of the wheel has 64
+ * slots, a slot of the level N spans 64^N ticks. Arming, re-arming and
+ * cancelling a timer cost O(1), the expired timers are collected on the tick
+ * advance, and a timer is moved to the lower level at most once per level.
+ *
+ * @tparam Key - the timer identifier type.
+ */
+template <typename Key>
+class TimerWheel
+{
+  public:
+    using Tick = uint64_t;
+
+    static constexpr unsigned int levelBits = 6U;
+    static constexpr unsigned int levels = 4U;
+    static constexpr Tick slotsPerLevel = Tick(1U) << levelBits;
+    static constexpr Tick slotMask = slotsPerLevel - 1U;
+    /** @brief The longest timeout the wheel can hold */
+    static constexpr Tick maxTimeout = (Tick(1U) << (levelBits * levels)) - 1U;
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+    TimerWheel(TimerWheel&&) = delete;
+    TimerWheel& operator=(TimerWheel&&) = delete;
+    ~TimerWheel() = default;
+
+    /** @brief Constructs the wheel
+     *
+     * @param[in] now   - the current tick
+     */
+    explicit TimerWheel(Tick now) : current(now)
+    {
+        for (auto& level : wheel)
+        {
+            level.fill(nullptr);
+        }
+    }
+
+    /**
+     * @brief Arm or re-arm the timer of the key.
+     *
+     * @param key       - the timer identifier
+     * @param expiry    - the tick to expire at. The value is clamped to the
+     *                    range the wheel can hold.
+     * @param now       - the current tick
+     */
+    void schedule(const Key& key, Tick expiry, Tick now)
+    {
+        if (nodes.empty())
+        {
+            // Nothing has advanced the idle wheel since its last timer was
+            // cancelled, so catch up before placing the timer.
+            current = std::max(current, now);
+        }
+        auto [it, inserted] = nodes.try_emplace(key);
+        Node& node = it->second;
+        if (inserted)
+        {
+            node.key = &it->first;
+        }
+        else
+        {
+            unlink(node);
+        }
+        if (expiry <= current)
+        {
+            expiry = current + 1U;
+        }
+        if (expiry - current > maxTimeout)
+        {
+            expiry = current + maxTimeout;
+        }
+        node.expiry = expiry;
+        link(node);
+    }
+
+    /**
+     * @brief Cancel the timer of the key.
+     *
+     * @return true if the timer has been armed.
+     */
+    bool cancel(const Key& key)
+    {
+        auto found = nodes.find(key);
+        if (found == nodes.end())
+        {
+            return false;
+        }
+        unlink(found->second);
+        nodes.erase(found);
+        return true;
+    }
+
+    /**
+     * @brief Advance the wheel up to the specified tick and collect the keys
+     *        of expired timers. The expired timers are disarmed.
+     *
+     * @param now       - the current tick
+     * @param expired   - the vector to append expired keys to
+     */
+    void advance(Tick now, std::vector<Key>& expired)
+    {
+        if (nodes.empty())
+        {
+            current = std::max(current, now);
+            return;
+        }
+        while (current < now)
+        {
+            ++current;
+            for (unsigned int level = 1U; level < levels; ++level)
+            {
+                // The upper level slot is cascaded when all lower level
+                // indexes wrap around.
+                const Tick lowerMask = (Tick(1U) << (levelBits * level)) - 1U;
+                if ((current & lowerMask) != 0U)
+                {
+                    break;
+                }
+                cascade(level);
+            }
+
+            Node* node = detach(0U, current & slotMask);
+            while (node != nullptr)
+            {
+                Node* next = node->next;
+                expired.push_back(*node->key);
+                nodes.erase(*node->key);
+                node = next;
+            }
+            if (nodes.empty())
+            {
+                current = now;
+            }
+        }
+    }
+
+    /** @brief Check whether no timer is armed. */
+    bool empty() const
+    {
+        return nodes.empty();
+    }
+
+    /** @brief Get the count of armed timers. */
+    std::size_t size() const
+    {
+        return nodes.size();
+    }
+
+  private:
+    struct Node
+    {
+        const Key* key = nullptr;
+        Tick expiry = 0U;
+        Node* prev = nullptr;
+        Node* next = nullptr;
+        unsigned int level = 0U;
+        Tick slot = 0U;
+    };
+
+    void link(Node& node)
+    {
+        const Tick delta = node.expiry - current;
+        unsigned int level = 0U;
+        while (level + 1U < levels &&
+               delta >= (Tick(1U) << (levelBits * (level + 1U))))
+        {
+            ++level;
+        }
+        node.level = level;
+        node.slot = (node.expiry >> (levelBits * level)) & slotMask;
+        Node*& head = wheel[level][node.slot];
+        node.prev = nullptr;
+        node.next = head;
+        if (head != nullptr)
+        {
+            head->prev = &node;
+        }
+        head = &node;
+    }
+
+    void unlink(Node& node)
+    {
+        if (node.prev != nullptr)
+        {
+            node.prev->next = node.next;
+        }
+        else
+        {
+            wheel[node.level][node.slot] = node.next;
+        }
+        if (node.next != nullptr)
+        {
+            node.next->prev = node.prev;
+        }
+        node.prev = nullptr;
+        node.next = nullptr;
+    }
+
+    Node* detach(unsigned int level, Tick slot)
+    {
+        Node* head = wheel[level][slot];
+        wheel[level][slot] = nullptr;
+        return head;
+    }
+
+    void cascade(unsigned int level)
+    {
+        Node* node = detach(level, (current >> (levelBits * level)) & slotMask);
+        while (node != nullptr)
+        {
+            Node* next = node->next;
+            link(*node);
+            node = next;
+        }
+    }
+
+    Tick current;
+    std::array<std::array<Node*, slotsPerLevel>, levels> wheel;
+    std::unordered_map<Key, Node> nodes;
+};
+
+} // namespace session
+} // namespace obmc
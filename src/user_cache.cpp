@@ -0,0 +1,352 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <phosphor-logging/log.hpp>
+#include <user_cache.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string_view>
+
+namespace obmc
+{
+namespace session
+{
+
+using namespace phosphor::logging;
+using namespace obmc::dbus;
+using namespace std::chrono_literals;
+namespace rules = sdbusplus::bus::match::rules;
+
+UserCache::UserCache(sdbusplus::bus::bus& bus, boost::asio::io_context& ioc,
+                     bool allowUnknown, RevokeHandler handler,
+                     LoadHandler loadHandler) :
+    bus(bus),
+    timer(ioc), allowUnknown(allowUnknown), handler(std::move(handler)),
+    loadHandler(std::move(loadHandler)), pendingCall(nullptr),
+    pendingReply(nullptr), loaded(false)
+{
+    // Subscribe first, so no change is lost between the load and the
+    // subscription.
+    const std::string usersPath = std::string(user_manager::root) + "/";
+    addedMatch = std::make_unique<sdbusplus::bus::match::match>(
+        bus, rules::interfacesAdded() + rules::argNpath(0, usersPath),
+        [this](sdbusplus::message::message& message) {
+            this->onInterfacesAdded(message);
+        });
+    removedMatch = std::make_unique<sdbusplus::bus::match::match>(
+        bus, rules::interfacesRemoved() + rules::argNpath(0, usersPath),
+        [this](sdbusplus::message::message& message) {
+            this->onInterfacesRemoved(message);
+        });
+    changedMatch = std::make_unique<sdbusplus::bus::match::match>(
+        bus,
+        rules::propertiesChangedNamespace(user_manager::root,
+                                          user_manager::attributesIface),
+        [this](sdbusplus::message::message& message) {
+            this->onPropertiesChanged(message);
+        });
+
+    load();
+}
+
+UserCache::~UserCache()
+{
+    // Unreferencing the slot cancels the call, so the reply never comes.
+    sd_bus_slot_unref(pendingCall);
+}
+
+bool UserCache::isAllowed(const std::string& userName) const
+{
+    if (!loaded)
+    {
+        return true;
+    }
+    auto found = users.find(userName);
+    if (found == users.end())
+    {
+        return allowUnknown;
+    }
+    return found->second.enabled && !found->second.locked;
+}
+
+std::string UserCache::getUserObjectPath(const std::string& userName)
+{
+    return std::string(user_manager::root) + "/" + userName;
+}
+
+void UserCache::load()
+{
+    try
+    {
+        auto getObject = bus.new_method_call(
+            object_mapper::service, object_mapper::object,
+            object_mapper::interface, object_mapper::getObject);
+        getObject.append(user_manager::root,
+                         std::vector<std::string>{user_manager::interface});
+        if (callAsync(getObject, &UserCache::onObjectReply))
+        {
+            return;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        log<level::WARNING>("Failure to request the user manager",
+                            entry("ERROR=%s", e.what()));
+    }
+    scheduleLoad();
+}
+
+void UserCache::onObjectReply(sdbusplus::message::message& reply)
+{
+    try
+    {
+        DBusGetObjectOut services;
+        reply.read(services);
+        if (!services.empty())
+        {
+            auto getManagedObjects = bus.new_method_call(
+                services.begin()->first.c_str(), user_manager::root,
+                freedesktop::objectManagerIface,
+                freedesktop::getManagedObjects);
+            if (callAsync(getManagedObjects, &UserCache::onUsersReply))
+            {
+                return;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        log<level::WARNING>("Failure to find the user manager",
+                            entry("ERROR=%s", e.what()));
+    }
+    scheduleLoad();
+}
+
+void UserCache::onUsersReply(sdbusplus::message::message& reply)
+{
+    try
+    {
+        freedesktop::ManagedObjectType objects;
+        reply.read(objects);
+
+        users.clear();
+        for (const auto& [path, interfaces] : objects)
+        {
+            const auto userName = getUserName(path);
+            const auto attributes =
+                interfaces.find(user_manager::attributesIface);
+            if (userName && attributes != interfaces.end())
+            {
+                update(users[*userName], attributes->second);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        log<level::WARNING>("Failure to load users from the user manager",
+                            entry("ERROR=%s", e.what()));
+        scheduleLoad();
+        return;
+    }
+
+    loaded = true;
+    log<level::INFO>("Loaded users from the user manager",
+                     entry("USERS=%zu", users.size()));
+    // The sessions created or restored while the users were unknown are
+    // checked now.
+    loadHandler();
+}
+
+bool UserCache::callAsync(sdbusplus::message::message& call,
+                          ReplyHandler replyHandler)
+{
+    sd_bus_slot_unref(pendingCall);
+    pendingCall = nullptr;
+    pendingReply = replyHandler;
+    const int rc = sd_bus_call_async(
+        bus.get(), &pendingCall, call.get(), &UserCache::onReply, this,
+        static_cast<uint64_t>(
+            std::chrono::microseconds(callTimeout).count()));
+    if (rc < 0)
+    {
+        log<level::WARNING>("Failure to call the user manager",
+                            entry("ERROR=%s", std::strerror(-rc)));
+        return false;
+    }
+    return true;
+}
+
+int UserCache::onReply(sd_bus_message* message, void* userdata,
+                       sd_bus_error*)
+{
+    auto cache = static_cast<UserCache*>(userdata);
+    // The call is complete, sd-bus keeps the slot alive within the callback.
+    sd_bus_slot_unref(cache->pendingCall);
+    cache->pendingCall = nullptr;
+
+    sdbusplus::message::message reply(message);
+    if (reply.is_method_error())
+    {
+        const auto error = sd_bus_message_get_error(message);
+        log<level::WARNING>(
+            "Failure to load users from the user manager",
+            entry("ERROR=%s", error != nullptr && error->message != nullptr
+                                  ? error->message
+                                  : "unknown"));
+        cache->scheduleLoad();
+        return 0;
+    }
+    (cache->*cache->pendingReply)(reply);
+    return 0;
+}
+
+void UserCache::scheduleLoad()
+{
+    timer.expires_from_now(10s);
+    timer.async_wait([this](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        this->load();
+    });
+}
+
+void UserCache::onInterfacesAdded(sdbusplus::message::message& message)
+{
+    // Any object under the user root matches, e.g. the LDAP privilege
+    // mappers, so an unexpected signal must not break the loop.
+    try
+    {
+        sdbusplus::message::object_path path;
+        freedesktop::DBusInteracesMap interfaces;
+        message.read(path, interfaces);
+
+        const auto userName = getUserName(path);
+        const auto attributes = interfaces.find(user_manager::attributesIface);
+        if (userName && attributes != interfaces.end())
+        {
+            update(users[*userName], attributes->second);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        log<level::WARNING>("Failure to handle the added user",
+                            entry("PATH=%s", message.get_path()),
+                            entry("ERROR=%s", e.what()));
+    }
+}
+
+void UserCache::onInterfacesRemoved(sdbusplus::message::message& message)
+{
+    try
+    {
+        sdbusplus::message::object_path path;
+        std::vector<std::string> interfaces;
+        message.read(path, interfaces);
+
+        const auto userName = getUserName(path);
+        if (userName && std::find(interfaces.begin(), interfaces.end(),
+                                  user_manager::attributesIface) !=
+                            interfaces.end())
+        {
+            users.erase(*userName);
+            handler(*userName);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        log<level::WARNING>("Failure to handle the removed user",
+                            entry("PATH=%s", message.get_path()),
+                            entry("ERROR=%s", e.what()));
+    }
+}
+
+void UserCache::onPropertiesChanged(sdbusplus::message::message& message)
+{
+    try
+    {
+        std::string interface;
+        freedesktop::DBusPropertiesMap properties;
+        message.read(interface, properties);
+
+        const auto userName = getUserName(message.get_path());
+        if (!userName)
+        {
+            return;
+        }
+        auto found = users.find(*userName);
+        if (found != users.end() && update(found->second, properties))
+        {
+            handler(*userName);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        log<level::WARNING>("Failure to handle the changed user",
+                            entry("PATH=%s", message.get_path()),
+                            entry("ERROR=%s", e.what()));
+    }
+}
+
+bool UserCache::update(User& user,
+                       const freedesktop::DBusPropertiesMap& properties)
+{
+    bool revoked = false;
+    for (const auto& [name, value] : properties)
+    {
+        if (name == "UserEnabled")
+        {
+            if (const auto enabled = std::get_if<bool>(&value))
+            {
+                revoked |= user.enabled && !*enabled;
+                user.enabled = *enabled;
+            }
+        }
+        else if (name == "UserLockedForFailedAttempt")
+        {
+            if (const auto locked = std::get_if<bool>(&value))
+            {
+                revoked |= !user.locked && *locked;
+                user.locked = *locked;
+            }
+        }
+        else if (name == "UserPrivilege")
+        {
+            if (const auto privilege = std::get_if<std::string>(&value))
+            {
+                revoked |= user.privilege != *privilege;
+                user.privilege = *privilege;
+            }
+        }
+        else if (name == "UserGroups")
+        {
+            if (const auto groups =
+                    std::get_if<std::vector<std::string>>(&value))
+            {
+                revoked |= user.groups != *groups;
+                user.groups = *groups;
+            }
+        }
+    }
+    return revoked;
+}
+
+std::optional<std::string>
+    UserCache::getUserName(const std::string& objectPath)
+{
+    const std::string_view root(user_manager::root);
+    if (objectPath.size() <= root.size() + 1U ||
+        objectPath.compare(0U, root.size(), root) != 0 ||
+        objectPath[root.size()] != '/' ||
+        objectPath.find('/', root.size() + 1U) != std::string::npos)
+    {
+        return std::nullopt;
+    }
+    return objectPath.substr(root.size() + 1U);
+}
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <dbus.hpp>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace obmc
+{
+namespace session
+{
+
+/**
+ * @brief Local copy of the users of xyz.openbmc_project.User.Manager.
+ *
+ * The cache is filled once at startup and kept current by the InterfacesAdded,
+ * InterfacesRemoved and PropertiesChanged signals of the user manager, so the
+ * user checks never make a dbus call. The users are loaded by asynchronous
+ * calls with a short timeout, so a slow user manager never stalls the event
+ * loop. If the user manager is not reachable at startup, the users are
+ * reloaded periodically and all users are allowed meanwhile; the load handler
+ * is invoked once they are loaded to recheck the sessions created before.
+ *
+ * The revoke handler is invoked within the signal handler when a user is
+ * deleted, disabled, locked or has the privilege or groups changed, so the
+ * sessions of the user are closed in the same event loop turn.
+ */
+class UserCache
+{
+  public:
+    /** @brief Attributes of the user the sessions depend on */
+    struct User
+    {
+        bool enabled = true;
+        bool locked = false;
+        std::string privilege;
+        std::vector<std::string> groups;
+    };
+
+    using RevokeHandler = std::function<void(const std::string& userName)>;
+    using LoadHandler = std::function<void()>;
+
+    /** @brief The timeout of the calls loading the users */
+    static constexpr auto callTimeout = std::chrono::seconds(5);
+
+    UserCache() = delete;
+    UserCache(const UserCache&) = delete;
+    UserCache& operator=(const UserCache&) = delete;
+    UserCache(UserCache&&) = delete;
+    UserCache& operator=(UserCache&&) = delete;
+
+    /** @brief Constructs the user cache and starts loading the users
+     *
+     * @param[in] bus               - Handle to system dbus
+     * @param[in] ioc               - ASIO context
+     * @param[in] allowUnknown      - allow users missing in the user manager,
+     *                                e.g. the LDAP ones
+     * @param[in] handler           - the callback to invoke for a user whose
+     *                                sessions have to be closed
+     * @param[in] loadHandler       - the callback to invoke when the users
+     *                                are loaded
+     */
+    UserCache(sdbusplus::bus::bus& bus, boost::asio::io_context& ioc,
+              bool allowUnknown, RevokeHandler handler,
+              LoadHandler loadHandler);
+
+    /** @brief Cancels the pending load call. */
+    ~UserCache();
+
+    /**
+     * @brief Check whether the user might own a session.
+     *
+     * @return true if the user exists, is enabled and not locked.
+     */
+    bool isAllowed(const std::string& userName) const;
+
+    /** @brief Get the object path of the user. */
+    static std::string getUserObjectPath(const std::string& userName);
+
+  private:
+    using ReplyHandler = void (UserCache::*)(sdbusplus::message::message&);
+
+    /** @brief Start loading all users: ask the mapper for the user manager. */
+    void load();
+
+    /** @brief Request the users from the service found by the mapper. */
+    void onObjectReply(sdbusplus::message::message& reply);
+
+    /** @brief Fill the cache with the users got from the user manager. */
+    void onUsersReply(sdbusplus::message::message& reply);
+
+    /**
+     * @brief Send the method call, the reply is passed to the specified
+     *        member.
+     *
+     * @return false if the call can't be sent.
+     */
+    bool callAsync(sdbusplus::message::message& call,
+                   ReplyHandler replyHandler);
+
+    static int onReply(sd_bus_message* message, void* userdata,
+                       sd_bus_error* error);
+
+    /** @brief Schedule the next attempt to load the users. */
+    void scheduleLoad();
+
+    void onInterfacesAdded(sdbusplus::message::message& message);
+    void onInterfacesRemoved(sdbusplus::message::message& message);
+    void onPropertiesChanged(sdbusplus::message::message& message);
+
+    /**
+     * @brief Apply the changed attributes to the user.
+     *
+     * @return true if the change revokes the sessions of the user.
+     */
+    static bool update(User& user,
+                       const dbus::freedesktop::DBusPropertiesMap& properties);
+
+    /** @brief Get the user name from the user object path. */
+    static std::optional<std::string>
+        getUserName(const std::string& objectPath);
+
+    sdbusplus::bus::bus& bus;
+    boost::asio::steady_timer timer;
+    const bool allowUnknown;
+    RevokeHandler handler;
+    LoadHandler loadHandler;
+    /** @brief The pending load call */
+    sd_bus_slot* pendingCall;
+    ReplyHandler pendingReply;
+    bool loaded;
+    std::unordered_map<std::string, User> users;
+    std::unique_ptr<sdbusplus::bus::match::match> addedMatch;
+    std::unique_ptr<sdbusplus::bus::match::match> removedMatch;
+    std::unique_ptr<sdbusplus::bus::match::match> changedMatch;
+};
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,274 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <dbus.hpp>
+#include <manager.hpp>
+#include <session.hpp>
+#include <virtual_objects.hpp>
+#include <xyz/openbmc_project/Association/Definitions/server.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+namespace obmc
+{
+namespace session
+{
+
+namespace
+{
+using AssocDefinitionServer =
+    sdbusplus::xyz::openbmc_project::Association::server::Definitions;
+
+const SessionRecord& toRecord(void* userdata)
+{
+    return *static_cast<const SessionRecord*>(userdata);
+}
+} // namespace
+
+const sdbusplus::vtable::vtable_t VirtualSessionObjects::itemVtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::property("SessionID", "s",
+                                VirtualSessionObjects::getSessionId),
+    sdbusplus::vtable::property("RemoteIPAddr", "s",
+                                VirtualSessionObjects::getRemoteAddress),
+    sdbusplus::vtable::property("Username", "s",
+                                VirtualSessionObjects::getUserName),
+    sdbusplus::vtable::property("SessionType", "s",
+                                VirtualSessionObjects::getSessionType),
+    sdbusplus::vtable::end()};
+
+const sdbusplus::vtable::vtable_t VirtualSessionObjects::assocVtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::property("Associations", "a(sss)",
+                                VirtualSessionObjects::getAssociations),
+    sdbusplus::vtable::end()};
+
+const sdbusplus::vtable::vtable_t VirtualSessionObjects::extVtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::property("RemainingLifetime", "t",
+                                VirtualSessionObjects::getRemainingLifetime),
+    sdbusplus::vtable::property("LastActivity", "t",
+                                VirtualSessionObjects::getLastActivity,
+                                sdbusplus::vtable::property_::emits_change),
+    sdbusplus::vtable::end()};
+
+VirtualSessionObjects::VirtualSessionObjects(sdbusplus::bus::bus& bus,
+                                             const char* prefix,
+                                             const SessionStore& store) :
+    bus(bus),
+    prefix(prefix), store(store), slots{}
+{
+    const std::array<std::pair<const char*, const sd_bus_vtable*>, 3>
+        vtables = {{
+            {SessionItemServer::interface, itemVtable},
+            {AssocDefinitionServer::interface, assocVtable},
+            {dbus::session_item::interface, extVtable},
+        }};
+    for (std::size_t i = 0U; i < vtables.size(); ++i)
+    {
+        const int rc = sd_bus_add_fallback_vtable(
+            bus.get(), &slots[i], prefix, vtables[i].first,
+            vtables[i].second, VirtualSessionObjects::find, this);
+        if (rc < 0)
+        {
+            throw sdbusplus::exception::SdBusError(
+                -rc, "Failure to add the session objects vtable");
+        }
+    }
+    const int rc =
+        sd_bus_add_node_enumerator(bus.get(), &slots[vtables.size()], prefix,
+                                   VirtualSessionObjects::enumerate, this);
+    if (rc < 0)
+    {
+        throw sdbusplus::exception::SdBusError(
+            -rc, "Failure to add the session objects enumerator");
+    }
+}
+
+VirtualSessionObjects::~VirtualSessionObjects()
+{
+    for (auto slot : slots)
+    {
+        sd_bus_slot_unref(slot);
+    }
+}
+
+void VirtualSessionObjects::emitAdded(SessionIdentifier id)
+{
+    SessionManager::ObjectPathBuffer path;
+    SessionManager::formatSessionObjectPath(id, path);
+    bus.emit_interfaces_added(path.data(), interfaces());
+}
+
+void VirtualSessionObjects::emitRemoved(SessionIdentifier id)
+{
+    SessionManager::ObjectPathBuffer path;
+    SessionManager::formatSessionObjectPath(id, path);
+    bus.emit_interfaces_removed(path.data(), interfaces());
+}
+
+void VirtualSessionObjects::emitLastActivity(SessionIdentifier id)
+{
+    SessionManager::ObjectPathBuffer path;
+    SessionManager::formatSessionObjectPath(id, path);
+    const int rc = sd_bus_emit_properties_changed(
+        bus.get(), path.data(), dbus::session_item::interface, "LastActivity",
+        nullptr);
+    if (rc < 0)
+    {
+        log<level::ERR>("Failure to emit the LastActivity change",
+                        entry("PATH=%s", path.data()),
+                        entry("ERROR=%s", std::strerror(-rc)));
+    }
+}
+
+const std::vector<std::string>& VirtualSessionObjects::interfaces()
+{
+    static const std::vector<std::string> names = {
+        SessionItemServer::interface,
+        AssocDefinitionServer::interface,
+        dbus::session_item::interface,
+    };
+    return names;
+}
+
+int VirtualSessionObjects::find(sd_bus*, const char* path, const char*,
+                                void* userdata, void** found, sd_bus_error*)
+{
+    const auto& self = *static_cast<VirtualSessionObjects*>(userdata);
+    const std::string_view objectPath(path);
+    if (objectPath.size() <= self.prefix.size() + 1U ||
+        objectPath.substr(0U, self.prefix.size()) != self.prefix ||
+        objectPath[self.prefix.size()] != '/')
+    {
+        return 0;
+    }
+
+    // The session objects are the direct children of the prefix only, the
+    // parser rejects the deeper paths as they contain the '/' character.
+    const auto sessionId = SessionManager::parseSessionId(
+        objectPath.substr(self.prefix.size() + 1U));
+    if (!sessionId)
+    {
+        return 0;
+    }
+    auto record = self.store.find(*sessionId);
+    if (record == nullptr)
+    {
+        return 0;
+    }
+    *found = record;
+    return 1;
+}
+
+int VirtualSessionObjects::enumerate(sd_bus*, const char*, void* userdata,
+                                     char*** nodes, sd_bus_error*)
+{
+    const auto& self = *static_cast<VirtualSessionObjects*>(userdata);
+    const auto ids = self.store.identifiers();
+
+    // The array and the strings are released by sd-bus.
+    auto paths =
+        static_cast<char**>(std::calloc(ids.size() + 1U, sizeof(char*)));
+    if (paths == nullptr)
+    {
+        return -ENOMEM;
+    }
+    for (std::size_t i = 0U; i < ids.size(); ++i)
+    {
+        SessionManager::ObjectPathBuffer path;
+        SessionManager::formatSessionObjectPath(ids[i], path);
+        paths[i] = ::strdup(path.data());
+        if (paths[i] == nullptr)
+        {
+            for (std::size_t j = 0U; j < i; ++j)
+            {
+                std::free(paths[j]);
+            }
+            std::free(static_cast<void*>(paths));
+            return -ENOMEM;
+        }
+    }
+    *nodes = paths;
+    return 0;
+}
+
+int VirtualSessionObjects::getSessionId(sd_bus*, const char*, const char*,
+                                        const char*, sd_bus_message* reply,
+                                        void* userdata, sd_bus_error*)
+{
+    SessionManager::SessionIdBuffer buffer;
+    SessionManager::formatSessionId(toRecord(userdata).id, buffer);
+    return sd_bus_message_append_basic(reply, 's', buffer.data());
+}
+
+int VirtualSessionObjects::getRemoteAddress(sd_bus*, const char*,
+                                            const char*, const char*,
+                                            sd_bus_message* reply,
+                                            void* userdata, sd_bus_error*)
+{
+    const auto address = SessionStore::getRemoteAddress(toRecord(userdata));
+    return sd_bus_message_append_basic(reply, 's', address.c_str());
+}
+
+int VirtualSessionObjects::getUserName(sd_bus*, const char*, const char*,
+                                       const char*, sd_bus_message* reply,
+                                       void* userdata, sd_bus_error*)
+{
+    return sd_bus_message_append_basic(
+        reply, 's', toRecord(userdata).userName->c_str());
+}
+
+int VirtualSessionObjects::getSessionType(sd_bus*, const char*, const char*,
+                                          const char*, sd_bus_message* reply,
+                                          void* userdata, sd_bus_error*)
+{
+    const auto type = convertForMessage(toRecord(userdata).type);
+    return sd_bus_message_append_basic(reply, 's', type.c_str());
+}
+
+int VirtualSessionObjects::getAssociations(sd_bus*, const char*, const char*,
+                                           const char*, sd_bus_message* reply,
+                                           void* userdata, sd_bus_error*)
+{
+    const auto associations =
+        SessionItem::getUserAssociations(*toRecord(userdata).userName);
+    int rc = sd_bus_message_open_container(reply, 'a', "(sss)");
+    for (const auto& [forward, reverse, path] : associations)
+    {
+        if (rc < 0)
+        {
+            return rc;
+        }
+        rc = sd_bus_message_append(reply, "(sss)", forward.c_str(),
+                                   reverse.c_str(), path.c_str());
+    }
+    if (rc < 0)
+    {
+        return rc;
+    }
+    return sd_bus_message_close_container(reply);
+}
+
+int VirtualSessionObjects::getRemainingLifetime(sd_bus*, const char*,
+                                                const char*, const char*,
+                                                sd_bus_message* reply,
+                                                void* userdata, sd_bus_error*)
+{
+    const uint64_t value =
+        SessionItemExt::secondsTill(toRecord(userdata).expiry);
+    return sd_bus_message_append_basic(reply, 't', &value);
+}
+
+int VirtualSessionObjects::getLastActivity(sd_bus*, const char*, const char*,
+                                           const char*, sd_bus_message* reply,
+                                           void* userdata, sd_bus_error*)
+{
+    const uint64_t value = toRecord(userdata).lastActivity;
+    return sd_bus_message_append_basic(reply, 't', &value);
+}
+
+} // namespace session
+} // namespace obmc
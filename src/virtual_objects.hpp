@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <sdbusplus/bus.hpp>
+#include <session_store.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace obmc
+{
+namespace session
+{
+
+/**
+ * @brief Serves the session objects straight from the session table.
+ *
+ * A single fallback vtable per interface and a node enumerator registered on
+ * the session manager object path answer for all session objects, so
+ * creating a session costs no sd-bus object registration. The
+ * InterfacesAdded and InterfacesRemoved signals are emitted explicitly.
+ * The properties of the virtual objects are read-only.
+ */
+class VirtualSessionObjects
+{
+  public:
+    VirtualSessionObjects() = delete;
+    VirtualSessionObjects(const VirtualSessionObjects&) = delete;
+    VirtualSessionObjects& operator=(const VirtualSessionObjects&) = delete;
+    VirtualSessionObjects(VirtualSessionObjects&&) = delete;
+    VirtualSessionObjects& operator=(VirtualSessionObjects&&) = delete;
+    ~VirtualSessionObjects();
+
+    /** @brief Registers the fallback vtables of session objects
+     *
+     * @param[in] bus       - Handle to system dbus
+     * @param[in] prefix    - The Dbus path the session objects live under
+     * @param[in] store     - the session table
+     */
+    VirtualSessionObjects(sdbusplus::bus::bus& bus, const char* prefix,
+                          const SessionStore& store);
+
+    /** @brief Emit the InterfacesAdded signal of the session object. */
+    void emitAdded(SessionIdentifier id);
+
+    /** @brief Emit the InterfacesRemoved signal of the session object. */
+    void emitRemoved(SessionIdentifier id);
+
+    /** @brief Emit the PropertiesChanged signal of LastActivity. */
+    void emitLastActivity(SessionIdentifier id);
+
+  private:
+    static int find(sd_bus* bus, const char* path, const char* interface,
+                    void* userdata, void** found, sd_bus_error* error);
+
+    static int enumerate(sd_bus* bus, const char* prefix, void* userdata,
+                         char*** nodes, sd_bus_error* error);
+
+    static int getSessionId(sd_bus* bus, const char* path,
+                            const char* interface, const char* property,
+                            sd_bus_message* reply, void* userdata,
+                            sd_bus_error* error);
+
+    static int getRemoteAddress(sd_bus* bus, const char* path,
+                                const char* interface, const char* property,
+                                sd_bus_message* reply, void* userdata,
+                                sd_bus_error* error);
+
+    static int getUserName(sd_bus* bus, const char* path,
+                           const char* interface, const char* property,
+                           sd_bus_message* reply, void* userdata,
+                           sd_bus_error* error);
+
+    static int getSessionType(sd_bus* bus, const char* path,
+                              const char* interface, const char* property,
+                              sd_bus_message* reply, void* userdata,
+                              sd_bus_error* error);
+
+    static int getAssociations(sd_bus* bus, const char* path,
+                               const char* interface, const char* property,
+                               sd_bus_message* reply, void* userdata,
+                               sd_bus_error* error);
+
+    static int getRemainingLifetime(sd_bus* bus, const char* path,
+                                    const char* interface,
+                                    const char* property,
+                                    sd_bus_message* reply, void* userdata,
+                                    sd_bus_error* error);
+
+    static int getLastActivity(sd_bus* bus, const char* path,
+                               const char* interface, const char* property,
+                               sd_bus_message* reply, void* userdata,
+                               sd_bus_error* error);
+
+    static const sdbusplus::vtable::vtable_t itemVtable[];
+    static const sdbusplus::vtable::vtable_t assocVtable[];
+    static const sdbusplus::vtable::vtable_t extVtable[];
+
+    /** @brief Get the names of all interfaces of the session object. */
+    static const std::vector<std::string>& interfaces();
+
+    sdbusplus::bus::bus& bus;
+    const std::string prefix;
+    const SessionStore& store;
+    std::array<sd_bus_slot*, 4> slots;
+};
+
+} // namespace session
+} // namespace obmc
@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <address_tree.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace obmc::session;
+
+namespace
+{
+
+in6_addr address(const char* text)
+{
+    const auto parsed = parseAddress(text);
+    if (!parsed)
+    {
+        throw std::invalid_argument(text);
+    }
+    return *parsed;
+}
+
+bool sameAddress(const in6_addr& a, const in6_addr& b)
+{
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+/** @brief The brute-force network membership of the model. */
+bool contains(const Network& network, const in6_addr& value)
+{
+    for (unsigned int i = 0U; i < network.length; ++i)
+    {
+        const auto mask = static_cast<uint8_t>(0x80U >> (i % 8U));
+        if ((network.prefix.s6_addr[i / 8U] & mask) !=
+            (value.s6_addr[i / 8U] & mask))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Get the network of the address, the bits beyond are zeroed. */
+Network network(const in6_addr& value, unsigned int length)
+{
+    Network result{in6_addr{}, length};
+    for (unsigned int i = 0U; i < length; ++i)
+    {
+        const auto mask = static_cast<uint8_t>(0x80U >> (i % 8U));
+        result.prefix.s6_addr[i / 8U] |= value.s6_addr[i / 8U] & mask;
+    }
+    return result;
+}
+
+TEST(AddressTest, Ipv4AndMappedAreSame)
+{
+    EXPECT_TRUE(
+        sameAddress(address("192.0.2.1"), address("::ffff:192.0.2.1")));
+    EXPECT_TRUE(
+        sameAddress(address("192.0.2.1"), address("::FFFF:c000:0201")));
+    EXPECT_EQ(formatAddress(address("::ffff:192.0.2.1")), "192.0.2.1");
+    EXPECT_EQ(normalizeAddress("::ffff:192.0.2.1"), "192.0.2.1");
+    EXPECT_FALSE(sameAddress(address("192.0.2.1"), address("::192.0.2.1")));
+}
+
+TEST(AddressTest, ZoneAndBracketsAreStripped)
+{
+    EXPECT_TRUE(sameAddress(address("fe80::1%eth0"), address("fe80::1")));
+    EXPECT_TRUE(sameAddress(address("[2001:db8::1]"), address("2001:db8::1")));
+    EXPECT_TRUE(sameAddress(address("[fe80::1%eth0]"), address("fe80::1")));
+    EXPECT_EQ(normalizeAddress("[2001:DB8:0::1]"), "2001:db8::1");
+    EXPECT_EQ(normalizeAddress("localhost"), "localhost");
+}
+
+TEST(AddressTest, MalformedAddressesAreRejected)
+{
+    for (const char* text :
+         {"", "[]", "[", "localhost", "192.0.2", "192.0.2.256", "1::2::3",
+          "192.0.2.1/24", "%eth0", "2001:db8::1 "})
+    {
+        EXPECT_FALSE(parseAddress(text)) << '"' << text << '"';
+    }
+}
+
+TEST(NetworkTest, PrefixLengthIsOfTheGivenFamily)
+{
+    const auto v4 = parseNetwork("10.1.2.3/16");
+    ASSERT_TRUE(v4);
+    EXPECT_EQ(v4->length, 96U + 16U);
+    EXPECT_TRUE(sameAddress(v4->prefix, address("10.1.0.0")));
+
+    const auto v6 = parseNetwork("fd00::1/8");
+    ASSERT_TRUE(v6);
+    EXPECT_EQ(v6->length, 8U);
+    EXPECT_TRUE(sameAddress(v6->prefix, address("fd00::")));
+
+    const auto single = parseNetwork("192.0.2.1");
+    ASSERT_TRUE(single);
+    EXPECT_EQ(single->length, 128U);
+
+    const auto all = parseNetwork("0.0.0.0/0");
+    ASSERT_TRUE(all);
+    EXPECT_EQ(all->length, 96U);
+}
+
+// CloseByNetwork and CountByNetwork fail with InvalidArgument exactly when
+// the network is rejected here.
+TEST(NetworkTest, MalformedNetworksAreRejected)
+{
+    for (const char* text :
+         {"", "/", "/8", "10.0.0.0/", "10.0.0.0/33", "10.0.0.0/-1",
+          "10.0.0.0/+8", "10.0.0.0/8/8", "10.0.0.0/8 ", "10.0.0.0/0x8",
+          "fd00::/129", "fd00::/ 8", "10.0.0/8", "host.example/8"})
+    {
+        EXPECT_FALSE(parseNetwork(text)) << '"' << text << '"';
+    }
+}
+
+TEST(AddressTreeTest, MatchesBruteForceModel)
+{
+    constexpr std::size_t operations = 50000U;
+    // A few clustered addresses, so the tree keeps splitting and merging
+    // the same inner nodes.
+    const std::vector<std::string> texts = {
+        "10.0.0.1",
+        "10.0.0.2",
+        "10.0.1.1",
+        "10.1.0.1",
+        "192.0.2.1",
+        "192.0.2.128",
+        "198.51.100.7",
+        "0.0.0.0",
+        "255.255.255.255",
+        "2001:db8::1",
+        "2001:db8::2",
+        "2001:db8:1::1",
+        "fe80::1",
+        "fd00::1",
+        "::",
+        "::1",
+        "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff",
+    };
+    std::vector<in6_addr> addresses;
+    for (const auto& text : texts)
+    {
+        addresses.push_back(address(text.c_str()));
+    }
+
+    std::mt19937 random(20211215U);
+    AddressTree tree;
+    std::map<SessionIdentifier, in6_addr> model;
+    for (std::size_t i = 0U; i < operations; ++i)
+    {
+        const SessionIdentifier id = random() % 512U + 1U;
+        auto found = model.find(id);
+        if (found != model.end())
+        {
+            tree.erase(found->second, id);
+            model.erase(found);
+        }
+        else
+        {
+            const auto& value = addresses[random() % addresses.size()];
+            tree.insert(value, id);
+            model.emplace(id, value);
+        }
+
+        // Any network around a known address: IPv4 ones are mapped.
+        const auto& base = addresses[random() % addresses.size()];
+        const auto length = static_cast<unsigned int>(random() % 129U);
+        const auto tested = network(base, length);
+
+        std::vector<SessionIdentifier> expected;
+        for (const auto& [expectedId, value] : model)
+        {
+            if (contains(tested, value))
+            {
+                expected.push_back(expectedId);
+            }
+        }
+        ASSERT_EQ(tree.count(tested), expected.size())
+            << "operation " << i << ", length " << length;
+        auto collected = tree.collect(tested);
+        std::sort(collected.begin(), collected.end());
+        ASSERT_EQ(collected, expected)
+            << "operation " << i << ", length " << length;
+
+        const auto& probe = addresses[random() % addresses.size()];
+        const auto sessions = tree.find(probe);
+        const auto expectedCount = static_cast<std::size_t>(
+            std::count_if(model.begin(), model.end(), [&probe](const auto& e) {
+                return sameAddress(e.second, probe);
+            }));
+        ASSERT_EQ(sessions != nullptr ? sessions->size() : 0U, expectedCount)
+            << "operation " << i;
+    }
+
+    // Erase everything, the tree must be empty again.
+    for (const auto& [id, value] : model)
+    {
+        tree.erase(value, id);
+    }
+    EXPECT_EQ(tree.count(Network{in6_addr{}, 0U}), 0U);
+    EXPECT_TRUE(tree.collect(Network{in6_addr{}, 0U}).empty());
+}
+
+} // namespace
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <private_bus.hpp>
+#include <session_client.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace obmc::session::bench;
+using namespace obmc::session::test;
+
+namespace
+{
+
+constexpr const char* invalidArgument =
+    "xyz.openbmc_project.Common.Error.InvalidArgument";
+
+/**
+ * `CloseByNetwork` and `CountByNetwork` take the network in the CIDR
+ * notation, reject a malformed one and treat IPv4 and IPv4-mapped addresses
+ * alike.
+ */
+class NetworkTest : public ::testing::Test
+{
+  protected:
+    static void SetUpTestSuite()
+    {
+        privateBus = std::make_unique<PrivateBus>();
+        service = std::make_unique<ServiceProcess>(getServicePath(),
+                                                   privateBus->getAddress());
+        service->waitReady();
+    }
+
+    static void TearDownTestSuite()
+    {
+        service.reset();
+        privateBus.reset();
+    }
+
+    static std::unique_ptr<PrivateBus> privateBus;
+    static std::unique_ptr<ServiceProcess> service;
+
+    SessionClient client{privateBus->getAddress()};
+};
+
+std::unique_ptr<PrivateBus> NetworkTest::privateBus;
+std::unique_ptr<ServiceProcess> NetworkTest::service;
+
+TEST_F(NetworkTest, MalformedNetworkIsRejected)
+{
+    for (const char* network :
+         {"", "10.0.0.0/", "10.0.0.0/33", "fd00::/129", "10.0.0.0/8/8",
+          "host.example/8"})
+    {
+        for (const char* method : {"CountByNetwork", "CloseByNetwork"})
+        {
+            try
+            {
+                client.callByNetwork(method, network);
+                ADD_FAILURE() << method << " accepted \"" << network << '"';
+            }
+            catch (const CallError& e)
+            {
+                EXPECT_EQ(e.getName(), invalidArgument)
+                    << method << " \"" << network << '"';
+            }
+        }
+    }
+}
+
+TEST_F(NetworkTest, CloseByNetworkClosesOnlyTheNetwork)
+{
+    const std::vector<std::string> inside = {
+        client.create("network", "192.0.2.1"),
+        client.create("network", "192.0.2.200"),
+        client.create("network", "::ffff:192.0.2.3"),
+    };
+    const std::vector<std::string> outside = {
+        client.create("network", "198.51.100.1"),
+        client.create("network", "2001:db8::1"),
+    };
+
+    EXPECT_EQ(client.callByNetwork("CountByNetwork", "192.0.2.0/24"),
+              inside.size());
+    EXPECT_EQ(client.callByNetwork("CountByNetwork", "::ffff:192.0.2.0/120"),
+              inside.size());
+    EXPECT_EQ(client.callByNetwork("CountByNetwork", "2001:db8::/32"), 1U);
+
+    EXPECT_EQ(client.callByNetwork("CloseByNetwork", "192.0.2.0/24"),
+              inside.size());
+    EXPECT_EQ(client.callByNetwork("CountByNetwork", "192.0.2.0/24"), 0U);
+    for (const auto& id : inside)
+    {
+        EXPECT_THROW(client.close(id), CallError) << id;
+    }
+    for (const auto& id : outside)
+    {
+        EXPECT_NO_THROW(client.close(id)) << id;
+    }
+}
+
+} // namespace
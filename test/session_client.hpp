@@ -0,0 +1,314 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#pragma once
+
+#include <private_bus.hpp>
+#include <systemd/sd-bus.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace obmc
+{
+namespace session
+{
+namespace test
+{
+
+constexpr const char* managerPath = "/xyz/openbmc_project/session_manager";
+constexpr const char* managerInterface = "xyz.openbmc_project.Session.Manager";
+constexpr const char* bulkInterface = "com.yadro.Session.Manager";
+constexpr const char* redfishType =
+    "xyz.openbmc_project.Session.Item.Type.Redfish";
+
+/**
+ * @brief Get the path of the service executable under test from the
+ *        `SESSION_MANAGER` environment variable set by the build.
+ */
+inline std::string getServicePath()
+{
+    const char* path = std::getenv("SESSION_MANAGER");
+    if (path == nullptr)
+    {
+        throw std::runtime_error("SESSION_MANAGER is not set");
+    }
+    return path;
+}
+
+/**
+ * @brief The failed call of the service.
+ */
+class CallError : public std::runtime_error
+{
+  public:
+    CallError(const char* name, const char* message) :
+        std::runtime_error(std::string(name != nullptr ? name : "") + ": " +
+                           (message != nullptr ? message : "")),
+        name(name != nullptr ? name : "")
+    {}
+
+    const std::string& getName() const
+    {
+        return name;
+    }
+
+  private:
+    std::string name;
+};
+
+/**
+ * @brief Client of the service on the private bus, which records all signals
+ *        the service emits.
+ *
+ * The calls are synchronous, the signals are dispatched by `sync()` and
+ * `waitClosed()` only.
+ */
+class SessionClient
+{
+  public:
+    /** @brief The arguments of the `SessionsClosed` signal */
+    struct Closed
+    {
+        std::string reason;
+        uint32_t count;
+    };
+
+    SessionClient() = delete;
+    SessionClient(const SessionClient&) = delete;
+    SessionClient& operator=(const SessionClient&) = delete;
+    SessionClient(SessionClient&&) = delete;
+    SessionClient& operator=(SessionClient&&) = delete;
+
+    /** @brief Connects the bus and subscribes to all signals.
+     *
+     * @param[in] address   - the address of the private bus
+     */
+    explicit SessionClient(const std::string& address) :
+        bus(bench::connectBus(address)), slot(nullptr)
+    {
+        // The signals carry the unique name of the sender, so they are
+        // filtered by the current owner of the service name.
+        sd_bus_error error = SD_BUS_ERROR_NULL;
+        sd_bus_message* reply = nullptr;
+        const char* owner = nullptr;
+        int rc = sd_bus_call_method(
+            bus, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+            "org.freedesktop.DBus", "GetNameOwner", &error, &reply, "s",
+            bench::ServiceProcess::serviceName);
+        if (rc >= 0)
+        {
+            rc = sd_bus_message_read(reply, "s", &owner);
+        }
+        if (rc >= 0)
+        {
+            serviceOwner = owner;
+            rc = sd_bus_add_match(bus, &slot, "type='signal'", onSignal,
+                                  this);
+        }
+        sd_bus_message_unref(reply);
+        sd_bus_error_free(&error);
+        if (rc < 0)
+        {
+            sd_bus_flush_close_unref(bus);
+            throw std::runtime_error("Failure to subscribe to the signals");
+        }
+    }
+
+    ~SessionClient()
+    {
+        sd_bus_slot_unref(slot);
+        sd_bus_flush_close_unref(bus);
+    }
+
+    /**
+     * @brief Create the session owned by the test process.
+     *
+     * @return std::string - the session ID.
+     */
+    std::string create(const std::string& userName,
+                       const std::string& remoteAddress,
+                       const char* type = redfishType)
+    {
+        sd_bus_error error = SD_BUS_ERROR_NULL;
+        sd_bus_message* reply = nullptr;
+        int rc = sd_bus_call_method(
+            bus, bench::ServiceProcess::serviceName, managerPath,
+            managerInterface, "Create", &error, &reply, "sssi",
+            userName.c_str(), remoteAddress.c_str(), type,
+            static_cast<int32_t>(::getpid()));
+        const char* sessionId = nullptr;
+        if (rc >= 0)
+        {
+            rc = sd_bus_message_read(reply, "s", &sessionId);
+        }
+        std::string result = rc >= 0 ? sessionId : "";
+        sd_bus_message_unref(reply);
+        if (rc < 0)
+        {
+            CallError failure(error.name, error.message);
+            sd_bus_error_free(&error);
+            throw failure;
+        }
+        return result;
+    }
+
+    /** @brief Close the session. */
+    void close(const std::string& sessionId)
+    {
+        sd_bus_error error = SD_BUS_ERROR_NULL;
+        const int rc = sd_bus_call_method(
+            bus, bench::ServiceProcess::serviceName, managerPath,
+            managerInterface, "Close", &error, nullptr, "s",
+            sessionId.c_str());
+        if (rc < 0)
+        {
+            CallError failure(error.name, error.message);
+            sd_bus_error_free(&error);
+            throw failure;
+        }
+    }
+
+    /**
+     * @brief Call the bulk method taking the network, e.g. `CountByNetwork`.
+     *
+     * @return uint32_t - count of the sessions within the network.
+     */
+    uint32_t callByNetwork(const char* method, const std::string& network)
+    {
+        sd_bus_error error = SD_BUS_ERROR_NULL;
+        sd_bus_message* reply = nullptr;
+        int rc = sd_bus_call_method(
+            bus, bench::ServiceProcess::serviceName, managerPath,
+            bulkInterface, method, &error, &reply, "s", network.c_str());
+        uint32_t count = 0U;
+        if (rc >= 0)
+        {
+            rc = sd_bus_message_read(reply, "u", &count);
+        }
+        sd_bus_message_unref(reply);
+        if (rc < 0)
+        {
+            CallError failure(error.name, error.message);
+            sd_bus_error_free(&error);
+            throw failure;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Dispatch all signals the service has emitted before it answered
+     *        the ping, which is ordered after the previous calls.
+     */
+    void sync()
+    {
+        sd_bus_error error = SD_BUS_ERROR_NULL;
+        const int rc = sd_bus_call_method(
+            bus, bench::ServiceProcess::serviceName, managerPath,
+            "org.freedesktop.DBus.Peer", "Ping", &error, nullptr, "");
+        sd_bus_error_free(&error);
+        if (rc < 0)
+        {
+            throw std::runtime_error("Failure to ping the service");
+        }
+        dispatch();
+    }
+
+    /**
+     * @brief Wait for the `SessionsClosed` signal.
+     *
+     * @param[in] timeout   - time to wait for the signal
+     *
+     * @return true if the signal is received.
+     */
+    bool waitClosed(std::chrono::milliseconds timeout)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        dispatch();
+        while (closed.empty())
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+            {
+                return false;
+            }
+            const auto left =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    deadline - now);
+            sd_bus_wait(bus, static_cast<uint64_t>(left.count()));
+            dispatch();
+        }
+        return true;
+    }
+
+    /** @brief Get count of the signals received since the last reset. */
+    std::size_t count(const std::string& member) const
+    {
+        const auto found = signals.find(member);
+        return found != signals.end() ? found->second : 0U;
+    }
+
+    /** @brief Get the `SessionsClosed` signals received since the last
+     *         reset.
+     */
+    const std::vector<Closed>& getClosed() const
+    {
+        return closed;
+    }
+
+    /** @brief Forget the received signals. */
+    void reset()
+    {
+        dispatch();
+        signals.clear();
+        closed.clear();
+    }
+
+  private:
+    void dispatch()
+    {
+        while (sd_bus_process(bus, nullptr) > 0)
+        {
+        }
+    }
+
+    static int onSignal(sd_bus_message* message, void* userdata,
+                        sd_bus_error*)
+    {
+        auto client = static_cast<SessionClient*>(userdata);
+        const char* sender = sd_bus_message_get_sender(message);
+        const char* member = sd_bus_message_get_member(message);
+        if (sender == nullptr || member == nullptr ||
+            client->serviceOwner != sender)
+        {
+            return 0;
+        }
+        ++client->signals[member];
+        if (std::string_view(member) == "SessionsClosed")
+        {
+            const char* reason = nullptr;
+            uint32_t count = 0U;
+            if (sd_bus_message_read(message, "su", &reason, &count) >= 0)
+            {
+                client->closed.push_back({reason, count});
+            }
+        }
+        return 0;
+    }
+
+    sd_bus* bus;
+    sd_bus_slot* slot;
+    std::string serviceOwner;
+    std::map<std::string, std::size_t> signals;
+    std::vector<Closed> closed;
+};
+
+} // namespace test
+} // namespace session
+} // namespace obmc
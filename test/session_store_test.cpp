@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <malloc.h>
+
+#include <session.hpp>
+#include <session_store.hpp>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace obmc::session;
+
+namespace
+{
+
+using SessionType = SessionStore::SessionType;
+
+/**
+ * The heap the store takes per session: the pooled record, its share of the
+ * hash table and of the interned strings. The table is at most half full, so
+ * it adds up to 32 bytes, and the pool and the vector growth add the rest.
+ */
+constexpr std::size_t maxHeapPerSession = 160U;
+
+std::size_t heapInUse()
+{
+    const struct mallinfo2 info = ::mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+/** @brief The session properties the store must give back */
+struct Expected
+{
+    std::string userName;
+    std::string remoteAddress;
+    SessionType type;
+    pid_t ownerPid;
+};
+
+TEST(StringInternerTest, SharesStringsByReference)
+{
+    StringInterner strings;
+    const auto first = strings.acquire("admin");
+    const auto second = strings.acquire(std::string("adm") + "in");
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(*first, "admin");
+    EXPECT_EQ(strings.size(), 1U);
+
+    strings.release(first);
+    EXPECT_EQ(strings.size(), 1U);
+    strings.release(second);
+    EXPECT_EQ(strings.size(), 0U);
+}
+
+TEST(SessionStoreTest, HeapPerSessionIsBounded)
+{
+    constexpr std::size_t sessionCount = 100000U;
+    std::vector<std::string> userNames;
+    for (std::size_t i = 0U; i < 64U; ++i)
+    {
+        userNames.push_back("user" + std::to_string(i));
+    }
+    std::vector<std::string> addresses;
+    for (std::size_t i = 0U; i < 250U; ++i)
+    {
+        addresses.push_back("10.0.0." + std::to_string(i));
+    }
+    const std::string noConnection;
+
+    const auto heapBefore = heapInUse();
+    SessionStore store;
+    for (std::size_t i = 0U; i < sessionCount; ++i)
+    {
+        store.insert(i + 1U, userNames[i % userNames.size()],
+                     addresses[i % addresses.size()], SessionType::Redfish,
+                     static_cast<pid_t>(1000U + i % 16U), noConnection,
+                     nullptr);
+    }
+    const auto heapAfter = heapInUse();
+    ASSERT_EQ(store.size(), sessionCount);
+
+    const auto perSession =
+        heapAfter > heapBefore ? (heapAfter - heapBefore) / sessionCount : 0U;
+    RecordProperty("HeapPerSession", static_cast<int>(perSession));
+    EXPECT_LE(perSession, maxHeapPerSession)
+        << "heap per session: " << perSession << " bytes";
+}
+
+TEST(SessionStoreTest, MatchesReferenceMap)
+{
+    constexpr std::size_t operations = 200000U;
+    // The narrow ID range keeps the table busy with collisions and erases
+    // from the middle of the probe sequences.
+    constexpr SessionIdentifier maxId = 4096U;
+    const std::vector<std::string> userNames = {"admin", "operator", "user",
+                                                "service"};
+    // Canonical addresses are kept parsed, the rest verbatim.
+    const std::vector<std::string> addresses = {
+        "192.0.2.1",        "198.51.100.7",       "2001:db8::1",
+        "fe80::1",          "::ffff:192.0.2.1",   "2001:DB8::1",
+        "fe80::1%eth0",     "[2001:db8::2]",      "localhost",
+        "",
+    };
+    const std::vector<std::string> connections = {"", ":1.7", ":1.42"};
+    const std::vector<SessionType> types = {
+        SessionType::Redfish, SessionType::HostConsole,
+        SessionType::ManagerConsole, SessionType::IPMI};
+
+    std::mt19937 random(20211201U);
+    auto pick = [&random](const auto& values) -> const auto& {
+        return values[random() % values.size()];
+    };
+
+    SessionStore store;
+    std::map<SessionIdentifier, Expected> reference;
+    for (std::size_t i = 0U; i < operations; ++i)
+    {
+        const SessionIdentifier id = random() % maxId + 1U;
+        auto found = reference.find(id);
+        auto record = store.find(id);
+        ASSERT_EQ(record != nullptr, found != reference.end()) << id;
+        if (found != reference.end())
+        {
+            EXPECT_EQ(*record->userName, found->second.userName);
+            EXPECT_EQ(SessionStore::getRemoteAddress(*record),
+                      found->second.remoteAddress);
+            EXPECT_EQ(record->type, found->second.type);
+            EXPECT_EQ(record->ownerPid, found->second.ownerPid);
+            store.erase(*record);
+            reference.erase(found);
+            ASSERT_FALSE(store.contains(id)) << id;
+        }
+        else
+        {
+            Expected expected{pick(userNames), pick(addresses), pick(types),
+                              static_cast<pid_t>(random() % 32768U + 1U)};
+            auto& inserted = store.insert(
+                id, expected.userName, expected.remoteAddress, expected.type,
+                expected.ownerPid, pick(connections), nullptr);
+            EXPECT_EQ(inserted.id, id);
+            reference.emplace(id, std::move(expected));
+        }
+        ASSERT_EQ(store.size(), reference.size());
+
+        if (i % 10000U == 0U)
+        {
+            auto ids = store.identifiers();
+            std::sort(ids.begin(), ids.end());
+            std::vector<SessionIdentifier> expectedIds;
+            for (const auto& [expectedId, properties] : reference)
+            {
+                expectedIds.push_back(expectedId);
+            }
+            ASSERT_EQ(ids, expectedIds);
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <session_table.hpp>
+#include <shared_table.hpp>
+
+#include <filesystem>
+#include <map>
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace obmc::session;
+using Status = table::Reader::Status;
+
+namespace
+{
+
+/**
+ * The table written by the service must answer the reader exactly as the
+ * sessions are, through the backward-shift erases and the growth, and say
+ * `unknown` whenever it can't tell.
+ */
+class SharedTableTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() /
+                    ("shared-table-test." + std::to_string(::getpid()));
+        std::filesystem::remove_all(directory);
+        path = (directory / "sessions.table").string();
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    /** @brief Read the header of the file currently at the path. */
+    table::Header readHeader() const
+    {
+        table::Header header{};
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            EXPECT_EQ(::pread(fd, &header, sizeof(header), 0),
+                      static_cast<ssize_t>(sizeof(header)));
+            ::close(fd);
+        }
+        return header;
+    }
+
+    std::filesystem::path directory;
+    std::string path;
+};
+
+TEST_F(SharedTableTest, LookupFollowsInsertAndErase)
+{
+    SharedSessionTable writer(path, SharedSessionTable::minCapacity);
+    writer.publish();
+    table::Reader reader(path.c_str());
+    table::Reader::Session session;
+
+    writer.insert(0x1a2b, "admin", 3U, 1234);
+    ASSERT_EQ(reader.lookup(0x1a2b, session), Status::valid);
+    EXPECT_EQ(session.id, 0x1a2bU);
+    EXPECT_EQ(session.ownerPid, 1234);
+    EXPECT_EQ(session.type, 3U);
+    EXPECT_EQ(session.userName(), "admin");
+    EXPECT_EQ(reader.lookup(0x1a2c, session), Status::invalid);
+
+    writer.erase(0x1a2b);
+    EXPECT_EQ(reader.lookup(0x1a2b, session), Status::invalid);
+}
+
+TEST_F(SharedTableTest, LongUserNameFillsTheField)
+{
+    SharedSessionTable writer(path);
+    writer.publish();
+    table::Reader reader(path.c_str());
+    table::Reader::Session session;
+
+    const std::string longName(table::maxUserNameLength + 8U, 'u');
+    writer.insert(1U, longName, 0U, 1);
+    ASSERT_EQ(reader.lookup(1U, session), Status::valid);
+    EXPECT_EQ(session.userName(),
+              longName.substr(0U, table::maxUserNameLength));
+}
+
+TEST_F(SharedTableTest, MatchesReferenceThroughGrowth)
+{
+    constexpr std::size_t operations = 100000U;
+    // The narrow ID range keeps the probe sequences long, so the erases
+    // shift the entries back all the time.
+    constexpr uint64_t maxId = 2048U;
+
+    SharedSessionTable writer(path, SharedSessionTable::minCapacity);
+    writer.publish();
+    table::Reader reader(path.c_str());
+    table::Reader::Session session;
+
+    std::mt19937 random(20211220U);
+    std::map<uint64_t, pid_t> reference;
+    for (std::size_t i = 0U; i < operations; ++i)
+    {
+        const uint64_t id = random() % maxId + 1U;
+        auto found = reference.find(id);
+        const auto status = reader.lookup(id, session);
+        if (found != reference.end())
+        {
+            ASSERT_EQ(status, Status::valid) << "operation " << i;
+            ASSERT_EQ(session.ownerPid, found->second) << "operation " << i;
+            writer.erase(id);
+            reference.erase(found);
+        }
+        else
+        {
+            ASSERT_EQ(status, Status::invalid) << "operation " << i;
+            const auto ownerPid = static_cast<pid_t>(random() % 32768U + 1U);
+            writer.insert(id, "user" + std::to_string(id % 8U), 0U,
+                          ownerPid);
+            reference.emplace(id, ownerPid);
+        }
+    }
+
+    // The table has grown from 16 slots and every session is still there.
+    EXPECT_GT(readHeader().capacity, SharedSessionTable::minCapacity);
+    EXPECT_EQ(readHeader().count, reference.size());
+    for (uint64_t id = 1U; id <= maxId; ++id)
+    {
+        const auto expected =
+            reference.count(id) != 0U ? Status::valid : Status::invalid;
+        ASSERT_EQ(reader.lookup(id, session), expected) << id;
+    }
+}
+
+TEST_F(SharedTableTest, GrowthRetiresThePublishedTable)
+{
+    SharedSessionTable writer(path, SharedSessionTable::minCapacity);
+    writer.publish();
+    table::Reader reader(path.c_str());
+    table::Reader::Session session;
+
+    // Watch the flags of the file published first.
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    ASSERT_GE(fd, 0);
+    void* oldMapping = ::mmap(nullptr, sizeof(table::Header), PROT_READ,
+                              MAP_SHARED, fd, 0);
+    ::close(fd);
+    ASSERT_NE(oldMapping, MAP_FAILED);
+    const auto& oldHeader = *static_cast<const table::Header*>(oldMapping);
+
+    // 3/4 of the slots fit, the next session grows the table.
+    const uint64_t fitting = SharedSessionTable::minCapacity * 3U / 4U;
+    for (uint64_t id = 1U; id <= fitting; ++id)
+    {
+        writer.insert(id, "admin", 0U, 1);
+    }
+    ASSERT_EQ(reader.lookup(1U, session), Status::valid);
+    EXPECT_EQ(oldHeader.flags & table::flagRetired, 0U);
+
+    writer.insert(fitting + 1U, "admin", 0U, 1);
+    EXPECT_NE(oldHeader.flags & table::flagRetired, 0U);
+    EXPECT_EQ(oldHeader.flags & table::flagComplete, 0U);
+    EXPECT_EQ(readHeader().capacity, SharedSessionTable::minCapacity * 2U);
+    EXPECT_EQ(readHeader().count, fitting + 1U);
+    EXPECT_NE(readHeader().flags & table::flagComplete, 0U);
+    ::munmap(oldMapping, sizeof(table::Header));
+
+    // The reader holding the retired table reopens the path.
+    for (uint64_t id = 1U; id <= fitting + 1U; ++id)
+    {
+        EXPECT_EQ(reader.lookup(id, session), Status::valid) << id;
+    }
+    EXPECT_FALSE(std::filesystem::exists(path + ".new"));
+    EXPECT_FALSE(std::filesystem::exists(path + ".grow"));
+}
+
+TEST_F(SharedTableTest, GrowthBeforePublishKeepsSessions)
+{
+    SharedSessionTable writer(path, SharedSessionTable::minCapacity);
+    for (uint64_t id = 1U; id <= 100U; ++id)
+    {
+        writer.insert(id, "admin", 0U, 1);
+    }
+    table::Reader reader(path.c_str());
+    table::Reader::Session session;
+    EXPECT_EQ(reader.lookup(1U, session), Status::unknown);
+
+    writer.publish();
+    EXPECT_EQ(readHeader().count, 100U);
+    for (uint64_t id = 1U; id <= 100U; ++id)
+    {
+        EXPECT_EQ(reader.lookup(id, session), Status::valid) << id;
+    }
+}
+
+TEST_F(SharedTableTest, AbsentOrIncompleteTableIsUnknown)
+{
+    table::Reader reader(path.c_str());
+    table::Reader::Session session;
+    EXPECT_EQ(reader.lookup(1U, session), Status::unknown);
+
+    {
+        SharedSessionTable writer(path);
+        writer.insert(1U, "admin", 0U, 1);
+        // Not published yet.
+        EXPECT_EQ(reader.lookup(1U, session), Status::unknown);
+        writer.publish();
+        EXPECT_EQ(reader.lookup(1U, session), Status::valid);
+        EXPECT_EQ(reader.lookup(2U, session), Status::invalid);
+    }
+    // The stopped service leaves the table incomplete.
+    EXPECT_EQ(reader.lookup(1U, session), Status::unknown);
+    EXPECT_EQ(reader.lookup(2U, session), Status::unknown);
+}
+
+TEST_F(SharedTableTest, CorruptTableIsUnknown)
+{
+    std::filesystem::create_directories(directory);
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0640);
+    ASSERT_GE(fd, 0);
+    table::Header header{};
+    header.magic = table::magic;
+    header.version = table::version;
+    header.capacity = 16U;
+    header.entrySize = sizeof(table::Entry);
+    header.flags = table::flagComplete;
+    // The file is shorter than the capacity says.
+    EXPECT_EQ(::write(fd, &header, sizeof(header)),
+              static_cast<ssize_t>(sizeof(header)));
+    ::close(fd);
+
+    table::Reader reader(path.c_str());
+    table::Reader::Session session;
+    EXPECT_EQ(reader.lookup(1U, session), Status::unknown);
+}
+
+TEST_F(SharedTableTest, LookupParsesHexId)
+{
+    SharedSessionTable writer(path);
+    writer.publish();
+    writer.insert(0xdeadbeef, "admin", 0U, 1);
+    table::Reader reader(path.c_str());
+    table::Reader::Session session;
+
+    EXPECT_EQ(reader.lookup(std::string_view("deadbeef"), session),
+              Status::valid);
+    EXPECT_EQ(session.id, 0xdeadbeefU);
+    EXPECT_EQ(reader.lookup(std::string_view("DEADBEEF"), session),
+              Status::valid);
+    EXPECT_EQ(reader.lookup(std::string_view("deadbeee"), session),
+              Status::invalid);
+    for (const char* malformed :
+         {"", "0", "00", "0xdeadbeef", "deadbeef ", " deadbeef", "-1",
+          "deadbeefg", "10000000000000000"})
+    {
+        EXPECT_EQ(reader.lookup(std::string_view(malformed), session),
+                  Status::invalid)
+            << '"' << malformed << '"';
+    }
+}
+
+} // namespace
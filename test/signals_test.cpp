@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <private_bus.hpp>
+#include <session_client.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace obmc::session::bench;
+using namespace obmc::session::test;
+
+namespace
+{
+
+constexpr std::size_t sessionCount = 16U;
+
+/**
+ * The session object must be announced by a single InterfacesAdded signal
+ * carrying all its properties and withdrawn by a single InterfacesRemoved
+ * one, never followed by a burst of PropertiesChanged signals.
+ */
+class SignalsTest : public ::testing::Test
+{
+  protected:
+    static void SetUpTestSuite()
+    {
+        privateBus = std::make_unique<PrivateBus>();
+        service = std::make_unique<ServiceProcess>(getServicePath(),
+                                                   privateBus->getAddress());
+        service->waitReady();
+    }
+
+    static void TearDownTestSuite()
+    {
+        service.reset();
+        privateBus.reset();
+    }
+
+    static std::string address(std::size_t index)
+    {
+        return "192.0.2." + std::to_string(index + 1U);
+    }
+
+    static std::unique_ptr<PrivateBus> privateBus;
+    static std::unique_ptr<ServiceProcess> service;
+
+    SessionClient client{privateBus->getAddress()};
+};
+
+std::unique_ptr<PrivateBus> SignalsTest::privateBus;
+std::unique_ptr<ServiceProcess> SignalsTest::service;
+
+TEST_F(SignalsTest, CreateEmitsSingleInterfacesAdded)
+{
+    std::vector<std::string> ids;
+    for (std::size_t i = 0U; i < sessionCount; ++i)
+    {
+        client.reset();
+        ids.push_back(client.create("signals", address(i)));
+        client.sync();
+        EXPECT_EQ(client.count("InterfacesAdded"), 1U) << "session " << i;
+        EXPECT_EQ(client.count("PropertiesChanged"), 0U) << "session " << i;
+    }
+    for (const auto& id : ids)
+    {
+        client.close(id);
+    }
+}
+
+TEST_F(SignalsTest, CloseEmitsSingleInterfacesRemoved)
+{
+    std::vector<std::string> ids;
+    for (std::size_t i = 0U; i < sessionCount; ++i)
+    {
+        ids.push_back(client.create("signals", address(i)));
+    }
+    for (const auto& id : ids)
+    {
+        client.reset();
+        client.close(id);
+        client.sync();
+        EXPECT_EQ(client.count("InterfacesRemoved"), 1U) << id;
+        EXPECT_EQ(client.count("PropertiesChanged"), 0U) << id;
+    }
+}
+
+} // namespace
@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <boost/asio.hpp>
+#include <dbus.hpp>
+#include <private_bus.hpp>
+#include <sdbusplus/asio/connection.hpp>
+#include <sdbusplus/asio/object_server.hpp>
+#include <session_client.hpp>
+#include <unistd.h>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace obmc::session::bench;
+using namespace obmc::session::test;
+using namespace std::chrono_literals;
+namespace dbus = obmc::dbus;
+
+namespace
+{
+
+constexpr const char* userManagerService = "xyz.openbmc_project.User.Manager";
+constexpr auto signalTimeout = 5s;
+
+/**
+ * @brief The object mapper and the user manager publishing the
+ *        `User.Attributes` objects, both served by the test process.
+ */
+class MockUserManager
+{
+  public:
+    MockUserManager() = delete;
+    MockUserManager(const MockUserManager&) = delete;
+    MockUserManager& operator=(const MockUserManager&) = delete;
+    MockUserManager(MockUserManager&&) = delete;
+    MockUserManager& operator=(MockUserManager&&) = delete;
+    ~MockUserManager() = default;
+
+    explicit MockUserManager(const std::string& address) :
+        conn(std::make_shared<sdbusplus::asio::connection>(
+            io, connectBus(address))),
+        server(conn, true)
+    {
+        conn->request_name(dbus::object_mapper::service);
+        conn->request_name(userManagerService);
+        server.add_manager(dbus::user_manager::root);
+
+        mapper = server.add_interface(dbus::object_mapper::object,
+                                      dbus::object_mapper::interface);
+        mapper->register_method(
+            dbus::object_mapper::getObject,
+            [](const std::string&, const std::vector<std::string>&) {
+                return dbus::DBusGetObjectOut{
+                    {userManagerService, {dbus::user_manager::interface}}};
+            });
+        mapper->initialize();
+    }
+
+    void addUser(const std::string& userName)
+    {
+        auto user = server.add_interface(userPath(userName),
+                                         dbus::user_manager::attributesIface);
+        user->register_property("UserPrivilege", std::string("priv-admin"));
+        user->register_property("UserGroups",
+                                std::vector<std::string>{"redfish", "ipmi"});
+        user->register_property("UserEnabled", true);
+        user->register_property("UserLockedForFailedAttempt", false);
+        user->register_property("UserPasswordExpired", false);
+        user->initialize();
+        users[userName] = std::move(user);
+    }
+
+    /** @brief Remove the user, which emits InterfacesRemoved. */
+    void deleteUser(const std::string& userName)
+    {
+        server.remove_interface(users.at(userName));
+        users.erase(userName);
+    }
+
+    /** @brief Change the user attribute, which emits PropertiesChanged. */
+    template <typename T>
+    void setProperty(const std::string& userName, const std::string& name,
+                     const T& value)
+    {
+        users.at(userName)->set_property(name, value);
+    }
+
+    /** @brief Serve the calls queued so far. */
+    void poll()
+    {
+        io.restart();
+        io.poll();
+    }
+
+    /**
+     * @brief Wait until the service has handled all signals emitted so far:
+     *        the ping from the same connection is ordered after them.
+     */
+    void sync()
+    {
+        auto ping = conn->new_method_call(ServiceProcess::serviceName,
+                                          managerPath,
+                                          "org.freedesktop.DBus.Peer", "Ping");
+        conn->call(ping);
+    }
+
+  private:
+    static std::string userPath(const std::string& userName)
+    {
+        return std::string(dbus::user_manager::root) + "/" + userName;
+    }
+
+    boost::asio::io_context io;
+    std::shared_ptr<sdbusplus::asio::connection> conn;
+    sdbusplus::asio::object_server server;
+    std::shared_ptr<sdbusplus::asio::dbus_interface> mapper;
+    std::map<std::string, std::shared_ptr<sdbusplus::asio::dbus_interface>>
+        users;
+};
+
+/**
+ * The sessions of a user are closed as soon as the user manager reports the
+ * user deleted, disabled, locked or having the privilege changed.
+ */
+class UserRevokeTest : public ::testing::Test
+{
+  protected:
+    static void SetUpTestSuite()
+    {
+        privateBus = std::make_unique<PrivateBus>();
+        userManager = std::make_unique<MockUserManager>(
+            privateBus->getAddress());
+        for (const char* userName :
+             {"alice", "bob", "carol", "dave", "erin", "frank"})
+        {
+            userManager->addUser(userName);
+        }
+        service = std::make_unique<ServiceProcess>(getServicePath(),
+                                                   privateBus->getAddress());
+        service->waitReady([] { userManager->poll(); });
+        waitUsersLoaded();
+    }
+
+    static void TearDownTestSuite()
+    {
+        service.reset();
+        userManager.reset();
+        privateBus.reset();
+    }
+
+    /**
+     * @brief Wait until the service has loaded the users: the session of an
+     *        unknown user is refused from then on.
+     */
+    static void waitUsersLoaded()
+    {
+        SessionClient probe(privateBus->getAddress());
+        const auto deadline = std::chrono::steady_clock::now() + signalTimeout;
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            userManager->poll();
+            try
+            {
+                const auto sessionId = probe.create("nobody", "192.0.2.1");
+                // Accepted before the load, it may be revoked meanwhile.
+                try
+                {
+                    probe.close(sessionId);
+                }
+                catch (const CallError&)
+                {}
+            }
+            catch (const CallError&)
+            {
+                return;
+            }
+            ::usleep(10000U);
+        }
+        throw std::runtime_error("The service has not loaded the users");
+    }
+
+    /**
+     * @brief Check the change of the user closes exactly the user sessions.
+     *
+     * @param[in] userName  - the user to change
+     * @param[in] change    - the change made by the user manager
+     */
+    void expectRevoked(const std::string& userName,
+                       const std::function<void()>& change)
+    {
+        const auto bystander = client.create("frank", "198.51.100.1");
+        const std::vector<std::string> ids = {
+            client.create(userName, "198.51.100.2"),
+            client.create(userName, "198.51.100.3"),
+        };
+        client.reset();
+
+        change();
+        userManager->sync();
+
+        ASSERT_TRUE(client.waitClosed(signalTimeout));
+        client.sync();
+        ASSERT_EQ(client.getClosed().size(), 1U);
+        EXPECT_EQ(client.getClosed().front().reason, "UserRevoked");
+        EXPECT_EQ(client.getClosed().front().count, ids.size());
+        EXPECT_EQ(client.count("InterfacesRemoved"), ids.size());
+        for (const auto& id : ids)
+        {
+            EXPECT_THROW(client.close(id), CallError) << id;
+        }
+        EXPECT_NO_THROW(client.close(bystander));
+    }
+
+    static std::unique_ptr<PrivateBus> privateBus;
+    static std::unique_ptr<MockUserManager> userManager;
+    static std::unique_ptr<ServiceProcess> service;
+
+    SessionClient client{privateBus->getAddress()};
+};
+
+std::unique_ptr<PrivateBus> UserRevokeTest::privateBus;
+std::unique_ptr<MockUserManager> UserRevokeTest::userManager;
+std::unique_ptr<ServiceProcess> UserRevokeTest::service;
+
+TEST_F(UserRevokeTest, UnknownUserIsRefused)
+{
+    EXPECT_THROW(client.create("nobody", "198.51.100.1"), CallError);
+}
+
+TEST_F(UserRevokeTest, DeletedUser)
+{
+    expectRevoked("alice", [] { userManager->deleteUser("alice"); });
+}
+
+TEST_F(UserRevokeTest, DisabledUser)
+{
+    expectRevoked("bob", [] {
+        userManager->setProperty("bob", "UserEnabled", false);
+    });
+}
+
+TEST_F(UserRevokeTest, LockedUser)
+{
+    expectRevoked("carol", [] {
+        userManager->setProperty("carol", "UserLockedForFailedAttempt", true);
+    });
+}
+
+TEST_F(UserRevokeTest, PrivilegeChanged)
+{
+    expectRevoked("dave", [] {
+        userManager->setProperty("dave", "UserPrivilege",
+                                 std::string("priv-user"));
+    });
+}
+
+TEST_F(UserRevokeTest, UnrelatedChangeKeepsSessions)
+{
+    const auto sessionId = client.create("erin", "198.51.100.4");
+    client.reset();
+
+    userManager->setProperty("erin", "UserPasswordExpired", true);
+    userManager->sync();
+    client.sync();
+
+    EXPECT_TRUE(client.getClosed().empty());
+    EXPECT_NO_THROW(client.close(sessionId));
+}
+
+} // namespace
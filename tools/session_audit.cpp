@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (C) 2021 YADRO
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <audit_log.hpp>
+#include <xyz/openbmc_project/Session/Item/server.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace obmc::session;
+using SessionItemServer =
+    sdbusplus::xyz::openbmc_project::Session::server::Item;
+
+namespace
+{
+
+using Record = AuditLog::Record;
+
+/**
+ * @brief Copy the records committed after the specified sequence number.
+ *        A record being overwritten by the service is skipped.
+ */
+std::vector<Record> collect(const Record* records, uint32_t capacity,
+                            uint64_t after)
+{
+    std::vector<Record> result;
+    for (uint32_t slot = 0U; slot < capacity; ++slot)
+    {
+        // The ring is written by the service concurrently: take the record
+        // only if its sequence number hasn't changed while it was copied.
+        auto& sequence = const_cast<uint64_t&>(records[slot].sequence);
+        const auto before =
+            std::atomic_ref<uint64_t>(sequence).load(std::memory_order_acquire);
+        if (before <= after)
+        {
+            continue;
+        }
+        Record copy;
+        std::memcpy(&copy, &records[slot], sizeof(copy));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (std::atomic_ref<uint64_t>(sequence).load(
+                std::memory_order_relaxed) != before)
+        {
+            continue;
+        }
+        copy.sequence = before;
+        result.push_back(copy);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const Record& a, const Record& b) {
+                  return a.sequence < b.sequence;
+              });
+    return result;
+}
+
+const char* eventName(AuditLog::Event event)
+{
+    switch (event)
+    {
+        case AuditLog::Event::created:
+            return "created";
+        case AuditLog::Event::closed:
+            return "closed";
+        case AuditLog::Event::rejected:
+            return "rejected";
+    }
+    return "unknown";
+}
+
+std::string typeName(uint8_t type)
+{
+    try
+    {
+        const auto name = SessionItemServer::convertTypeToString(
+            static_cast<SessionItemServer::Type>(type));
+        return name.substr(name.find_last_of('.') + 1U);
+    }
+    catch (const std::exception&)
+    {
+        return std::to_string(type);
+    }
+}
+
+template <std::size_t size>
+std::string_view field(const char (&value)[size])
+{
+    return std::string_view(value, ::strnlen(value, size));
+}
+
+void print(const Record& record)
+{
+    const auto seconds = static_cast<std::time_t>(record.timestamp / 1000000U);
+    struct tm utc
+    {};
+    ::gmtime_r(&seconds, &utc);
+    std::array<char, 32> time{};
+    std::strftime(time.data(), time.size(), "%Y-%m-%dT%H:%M:%S", &utc);
+
+    const auto cause = field(record.cause);
+    const auto userName = field(record.userName);
+    const auto remoteAddress = field(record.remoteAddress);
+    std::printf("%s.%06" PRIu64 "Z %" PRIu64 " %s %.*s %016" PRIx64
+                " %.*s %.*s %s %d\n",
+                time.data(), record.timestamp % 1000000U, record.sequence,
+                eventName(record.event), static_cast<int>(cause.size()),
+                cause.data(), record.id, static_cast<int>(userName.size()),
+                userName.data(),
+                static_cast<int>(remoteAddress.size()), remoteAddress.data(),
+                typeName(record.type).c_str(), record.ownerPid);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    bool follow = false;
+    int opt;
+    while ((opt = ::getopt(argc, argv, "f")) != -1)
+    {
+        if (opt != 'f')
+        {
+            std::fprintf(stderr, "Usage: %s [-f] [PATH]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        follow = true;
+    }
+    const std::string path =
+        optind < argc ? argv[optind] : AuditLog::defaultPath;
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        std::fprintf(stderr, "Failure to open %s: %s\n", path.c_str(),
+                     std::strerror(errno));
+        return EXIT_FAILURE;
+    }
+    AuditLog::Header header{};
+    struct stat st
+    {};
+    if (::pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        ::fstat(fd, &st) != 0 || header.magic != AuditLog::magic ||
+        header.version != AuditLog::version ||
+        header.recordSize != sizeof(Record) ||
+        static_cast<std::size_t>(st.st_size) !=
+            AuditLog::fileSize(header.capacity))
+    {
+        std::fprintf(stderr, "%s is not a session audit log\n", path.c_str());
+        ::close(fd);
+        return EXIT_FAILURE;
+    }
+    const auto size = AuditLog::fileSize(header.capacity);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::fprintf(stderr, "Failure to map %s: %s\n", path.c_str(),
+                     std::strerror(errno));
+        return EXIT_FAILURE;
+    }
+    const auto records = reinterpret_cast<const Record*>(
+        static_cast<const uint8_t*>(mapping) + sizeof(AuditLog::Header));
+
+    uint64_t last = 0U;
+    do
+    {
+        for (const auto& record : collect(records, header.capacity, last))
+        {
+            print(record);
+            last = record.sequence;
+        }
+        std::fflush(stdout);
+    } while (follow && ::sleep(1) == 0);
+
+    ::munmap(mapping, size);
+    return EXIT_SUCCESS;
+}